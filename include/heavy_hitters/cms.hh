@@ -25,8 +25,8 @@
 #include <algorithm>
 #include <iostream>
 #include <limits>
+#include <stdexcept>
 #include <vector>
-#include <functional>
 
 //! \namespace hmi_tree_optimization
 //! \brief Project namespace
@@ -51,6 +51,12 @@ namespace hmi_tree_optimization {
          * of an element. This is why the 'count' operation returns the minimum 
          * count of each bucket where a given element's counter is located.
          *
+         * Sketches with identical hash functions (see CMS::shard) can be
+         * merged by summing up their counters. Hence, several producer
+         * threads may each count their elements in a shard of their own,
+         * without any locking, and the shards may be merged into a global
+         * sketch at a synchronization point (e.g. at each frame boundary).
+         *
          * \see http://timroughgarden.org/s17/l/l2.pdf
          *
          * \tparam T Type of counted numeric elements.
@@ -77,10 +83,81 @@ namespace hmi_tree_optimization {
                   epsilon_(1.0 / (2 * k)),
                   nbuckets_(exp(1) / epsilon_),
                   nhfuns_(ceil(log(1.0 / errpr))),
-                  sketch_(nhfuns_, std::vector<size_t>(nbuckets_, 0)),
+                  mass_(0),
+                  sketch_(nhfuns_ * nbuckets_, 0),
+                  prime_(generate_random_prime()),
                   hfuns_(generate_hash_functions()) {
             }
 
+            /*!
+             * \brief Create an empty shard of this sketch
+             *
+             * The shard uses the same hash functions as this sketch, hence
+             * it may later be merged into it.
+             *
+             * \see CMS::merge
+             *
+             * \return Empty sketch with identical parameters.
+             */
+            CMS shard() const {
+                CMS res(*this);
+
+                res.clear();
+                return res;
+            }
+
+            /*!
+             * \brief Add the counters of another sketch to this one
+             *
+             * The other sketch must use the same hash functions (i.e. it is
+             * a shard of this sketch or vice versa). Its total weight is
+             * added to this sketch's as well.
+             *
+             * \note If the sketches' hash functions differ, a std::invalid_argument <!--
+             * --> exception is thrown.
+             *
+             * \param other Merged sketch.
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            CMS& merge(const CMS& other) {
+                if (nbuckets_ != other.nbuckets_ || prime_ != other.prime_ || hfuns_ != other.hfuns_)
+                    throw std::invalid_argument("merged count-min sketches must use the same hash functions");
+
+                size_t *counters = sketch_.data();
+                const size_t *other_counters = other.sketch_.data();
+
+                // a plain loop over contiguous counters is vectorized by the compiler
+                for (size_t i = 0, n = sketch_.size(); i < n; ++i)
+                    counters[i] += other_counters[i];
+                mass_ += other.mass_;
+                return *this;
+            }
+
+            /*!
+             * \brief Reset all counters (but not the hash functions)
+             *
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            CMS& clear() noexcept {
+                std::fill(sketch_.begin(), sketch_.end(), 0);
+                mass_ = 0;
+                return *this;
+            }
+
+            /*!
+             * \brief Return the total weight of all counted elements
+             *
+             * \return Total weight of the input stream (its size if no <!--
+             * --> occurrence has been weighted).
+             */
+            size_t mass() const noexcept {
+                return mass_;
+            }
+
             /*!
              * \brief Return the approximate frequency count of an element
              *
@@ -91,25 +168,32 @@ namespace hmi_tree_optimization {
              * \param x Element whose count is required.
              * \return Approximate frequency count of an element.
              */
-            size_t count(const T& x) noexcept {
+            size_t count(const T& x) const noexcept {
                 size_t min_count = std::numeric_limits<size_t>::max();
 
                 for (size_t l = 0; l < nhfuns_; ++l)
-                    min_count = std::min(sketch_[l][hfuns_[l](x)], min_count);
+                    min_count = std::min(sketch_[l * nbuckets_ + hash(l, x)], min_count);
                 return min_count;
             }
 
             /*!
              * \brief Increment all counters, associated with a given element
              *
+             * An occurrence may be weighted, e.g. by the cost of processing
+             * the element. The count of an element is then its weighted
+             * frequency, which must be compared against the total weight of
+             * the input stream (rather than its size).
+             *
              * \param x Element whose counters are incremented.
+             * \param weight Weight of the element's occurrence.
              * \return Reference to this instance.
              *
              * \remark The returned reference to this may be used for method chaining.
              */
-            CMS& increment(const T& x) noexcept {
+            CMS& increment(const T& x, size_t weight = 1) noexcept {
                 for (size_t l = 0; l < nhfuns_; ++l)
-                    ++sketch_[l][hfuns_[l](x)];
+                    sketch_[l * nbuckets_ + hash(l, x)] += weight;
+                mass_ += weight;
                 return *this;
             }
 
@@ -128,10 +212,11 @@ namespace hmi_tree_optimization {
                     << ", l=" << nhfuns_
                     << ", b=" << nbuckets_
                     << ", d=" << errpr_
+                    << ", m=" << mass_
                     << "}" << std::endl;
                 for (size_t l = 0; l < nhfuns_; ++l) {
                     for (size_t b = 0; b < nbuckets_; ++b) 
-                        out << sketch_[l][b] << '|';
+                        out << sketch_[l * nbuckets_ + b] << '|';
                     out << std::endl;
                 }
                 return *this;
@@ -139,13 +224,48 @@ namespace hmi_tree_optimization {
 
         private:
 
-            const size_t k_;  /*!< Maximum amount of heavy hitters. */
-            const double errpr_;  /*!< Target counting error probability. */
-            const double epsilon_;  /*!< Additive factor. */
-            const size_t nbuckets_;  /*!< Number of buckets. */
-            const size_t nhfuns_;  /*!< Number of hashing functions. */
-            std::vector<std::vector<size_t>> sketch_;  /*!< 2D sketch array. */
-            const std::vector<std::function<size_t(const T&)>> hfuns_;  /*!< Universal hashing functions. */
+            /*!
+             * \struct HashFunction
+             *
+             * \brief Coefficients of a universal hashing function
+             *
+             * \details The coefficients are stored by value (rather than <!--
+             * --> captured by a lambda alongside the sketch's address), <!--
+             * --> hence copies of a sketch hash elements identically.
+             */
+            struct HashFunction {
+                uint32_t a;  /*!< Multiplier; cannot be 0. */
+                uint32_t b;  /*!< Offset. */
+
+                bool operator==(const HashFunction& other) const noexcept {
+                    return a == other.a && b == other.b;
+                }
+
+                bool operator!=(const HashFunction& other) const noexcept {
+                    return !(*this == other);
+                }
+            };
+
+            size_t k_;  /*!< Maximum amount of heavy hitters. */
+            double errpr_;  /*!< Target counting error probability. */
+            double epsilon_;  /*!< Additive factor. */
+            size_t nbuckets_;  /*!< Number of buckets. */
+            size_t nhfuns_;  /*!< Number of hashing functions. */
+            size_t mass_;  /*!< Total weight of all counted elements. */
+            std::vector<size_t> sketch_;  /*!< Sketch array (one row of buckets per hashing function). */
+            uint32_t prime_;  /*!< Prime modulus, shared by all hashing functions. */
+            std::vector<HashFunction> hfuns_;  /*!< Universal hashing functions. */
+
+            /*!
+             * \brief Hash an element with one of the sketch's hashing functions.
+             *
+             * \param l Index of hashing function.
+             * \param x Hashed element.
+             * \return Bucket of the element in the hashing function's row.
+             */
+            size_t hash(size_t l, const T& x) const noexcept {
+                return ((hfuns_[l].a * x + hfuns_[l].b) % prime_) % nbuckets_;
+            }
 
             /*!
              * \brief Generate a set of hash functions from the same universal family.
@@ -160,22 +280,19 @@ namespace hmi_tree_optimization {
              *     generated functions;
              *     b - number of buckets in the sketch.
              *
-             * \remark All hashing functions are C++ lambda functions.
+             * \remark The prime modulus must have been generated beforehand.
              *
-             * \return Collection of generated hashing lambdas.
+             * \return Collection of generated hashing functions' coefficients.
              */
-            std::vector<std::function<size_t(const T&)>> generate_hash_functions() noexcept {
-                std::vector<std::function<size_t(const T&)>> hfuns;
+            std::vector<HashFunction> generate_hash_functions() noexcept {
+                std::vector<HashFunction> hfuns;
                 uint32_t a;
                 uint32_t b;
-                uint32_t p = generate_random_prime();
 
                 for (size_t l = 0; l < nhfuns_; ++l) {
-                    a = rand() % (p - 2) + 1;
-                    b = rand() % (p - 1);
-                    hfuns.push_back([a, b, p, this](const T& x) { 
-                            return ((a * x + b) % p) % nbuckets_; 
-                            });
+                    a = rand() % (prime_ - 2) + 1;
+                    b = rand() % (prime_ - 1);
+                    hfuns.push_back(HashFunction{a, b});
                 }
                 return hfuns;
             }
@@ -0,0 +1,136 @@
+/*!
+ * \file include/heavy_hitters/cms_shards.hh
+ * \brief Define per-thread shards of a count-min sketch
+ *
+ * Updates of an HMI may arrive from several producer threads (e.g. vehicle
+ * bus, media and navigation). Counting all of them in a single sketch would
+ * require either funneling them through one thread or locking the sketch on
+ * each increment. Instead, each producer counts its elements in a shard of
+ * its own and the shards are merged into the global sketch at each frame
+ * boundary.
+ *
+ * The simulation (see src/solution/main.cc) reads all updates from a single
+ * input stream, hence it counts them in one sketch directly. The shards are
+ * exercised by the benchmark's sketch scenario (see src/benchmark/main.cc).
+ *
+ * \see include/heavy_hitters/cms.hh
+ *
+ * \author Petar Nikolov
+ * \version v1.0.0
+ */
+
+#ifndef HMI_TREE_OPTIMIZATION__HEAVY_HITTERS__CMS_SHARDS_HH
+#define HMI_TREE_OPTIMIZATION__HEAVY_HITTERS__CMS_SHARDS_HH
+
+#include <cstddef>
+#include <vector>
+
+#include "heavy_hitters/cms.hh"
+
+//! \namespace hmi_tree_optimization
+//! \brief Project namespace
+namespace hmi_tree_optimization {
+    //! \namespace heavy_hitters
+    //! \brief Defines data structure and the required functionality to solve the Heavy Hitters problem
+    namespace heavy_hitters {
+        /*!
+         * \class CMSShards
+         *
+         * \brief Lock-free ingestion of elements into a count-min sketch by several threads
+         *
+         * Each shard is an empty copy of the global sketch (with identical
+         * hash functions) which is owned by a single producer thread. Hence,
+         * incrementing a shard requires no locking. The producers must be
+         * paused while the shards are merged into the global sketch.
+         *
+         * The shards are padded, so that no two of them share a cache line.
+         * Otherwise, each increment of a shard's mass would invalidate the
+         * line of its neighbor in the other producers' caches (false
+         * sharing).
+         *
+         * \see CMS::shard
+         * \see CMS::merge
+         *
+         * \tparam T Type of counted numeric elements.
+         */
+        template<typename T>
+        class CMSShards final {
+
+        public:
+
+            /*!
+             * \brief Constructor for sketch shards
+             *
+             * \param global Sketch which the shards are merged into.
+             * \param nshards Number of shards (one per producer thread).
+             */
+            CMSShards(CMS<T>& global, size_t nshards)
+                : global_(global),
+                  shards_(nshards, Shard(global.shard())) {
+            }
+
+            /*!
+             * \brief Access a producer's shard
+             *
+             * \note Each shard may only be accessed by one thread at a time.
+             *
+             * \param i Index of shard.
+             * \return The producer's shard.
+             */
+            CMS<T>& shard(size_t i) noexcept {
+                return shards_[i].sketch;
+            }
+
+            /*!
+             * \brief Return the number of shards
+             *
+             * \return Number of shards.
+             */
+            size_t size() const noexcept {
+                return shards_.size();
+            }
+
+            /*!
+             * \brief Merge all shards into the global sketch and empty them
+             *
+             * \warning No shard may be incremented during the merge.
+             *
+             * \return Global sketch.
+             */
+            CMS<T>& merge() {
+                for (auto& shard : shards_) {
+                    global_.merge(shard.sketch);
+                    shard.sketch.clear();
+                }
+                return global_;
+            }
+
+        private:
+
+            static constexpr size_t cache_line_size = 64;  /*!< Size (in bytes) of a cache line. */
+
+            /*!
+             * \struct Shard
+             *
+             * \brief A producer's sketch, followed by a cache line of padding
+             *
+             * \details Padding is used instead of alignas, since std::vector <!--
+             * --> does not allocate over-aligned elements before C++17.
+             */
+            struct Shard {
+                explicit Shard(const CMS<T>& empty_sketch)
+                    : sketch(empty_sketch),
+                      padding() {
+                }
+
+                CMS<T> sketch;  /*!< The producer's sketch. */
+                char padding[cache_line_size];  /*!< Keeps the next shard's sketch off this one's cache lines. */
+            };
+
+            CMS<T>& global_;  /*!< Sketch which the shards are merged into. */
+            std::vector<Shard> shards_;  /*!< Per-producer shards. */
+        };  // class CMSShards
+    }  // namespace heavy_hitters
+}  // namespace hmi_tree_optimization
+
+#endif  // HMI_TREE_OPTIMIZATION__HEAVY_HITTERS__CMS_SHARDS_HH
@@ -0,0 +1,190 @@
+/*!
+ * \file include/heavy_hitters/interval_estimator.hh
+ * \brief Define an estimator of the intervals between an element's occurrences
+ *
+ * Many elements of an input stream occur on a fixed schedule (e.g. a clock
+ * which is updated once per minute). A frequency count alone does not tell
+ * such an element apart from one which occurs in bursts. The estimator defined
+ * below tracks the mean interval between consecutive occurrences of each
+ * element instead, i.e. its period.
+ *
+ * \author Petar Nikolov
+ * \version v1.0.0
+ */
+
+#ifndef HMI_TREE_OPTIMIZATION__HEAVY_HITTERS__INTERVAL_ESTIMATOR_HH
+#define HMI_TREE_OPTIMIZATION__HEAVY_HITTERS__INTERVAL_ESTIMATOR_HH
+
+#include <cstddef>
+#include <iostream>
+#include <limits>
+#include <unordered_map>
+
+//! \namespace hmi_tree_optimization
+//! \brief Project namespace
+namespace hmi_tree_optimization {
+    //! \namespace heavy_hitters
+    //! \brief Defines data structure and the required functionality to solve the Heavy Hitters problem
+    namespace heavy_hitters {
+        /*!
+         * \class IntervalEstimator
+         *
+         * \brief Estimates the period of each element of an input stream
+         *
+         * Each element's occurrences are stamped with a discrete time (e.g.
+         * a frame number). The interval since the element's previous
+         * occurrence is folded into an exponentially weighted moving average.
+         * Recent intervals therefore weigh more than old ones, and a single
+         * irregular interval does not skew the estimate for long.
+         *
+         * Only two numbers and a time stamp are stored per element.
+         *
+         * \tparam T Type of stamped elements.
+         *
+         * \note The template parameter T must be hashable.
+         */
+        template<typename T>
+        class IntervalEstimator final {
+
+        public:
+
+            /*!
+             * \brief Constructor for interval estimator
+             *
+             * \param smoothing Weight of the newest interval in the moving <!--
+             * --> average; value is between 0 and 1.
+             */
+            explicit IntervalEstimator(double smoothing = 0.25) noexcept
+                : smoothing_(smoothing) {
+            }
+
+            /*!
+             * \brief Record an occurrence of an element
+             *
+             * \note Several occurrences at the same time count as one.
+             *
+             * \param x Element which occurs.
+             * \param time Time of occurrence; must not decrease between calls.
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            IntervalEstimator& record(const T& x, size_t time) {
+                auto inserted = stamps_.insert(std::make_pair(x, Stamp{time, 0.0}));
+                Stamp& stamp = inserted.first->second;
+
+                if (inserted.second || time == stamp.last)
+                    return *this;
+
+                double interval = static_cast<double>(time - stamp.last);
+
+                if (stamp.period == 0.0)  // second occurrence
+                    stamp.period = interval;
+                else
+                    stamp.period += smoothing_ * (interval - stamp.period);
+                stamp.last = time;
+                return *this;
+            }
+
+            /*!
+             * \brief Return the estimated period of an element
+             *
+             * If the time elapsed since the element's latest occurrence
+             * already exceeds its estimated period, that elapsed time is
+             * folded into the estimate as if the element occurred now. Hence,
+             * an element which stops occurring is not considered periodic for
+             * ever.
+             *
+             * \param x Element whose period is required.
+             * \param time Current time; must not precede the latest occurrence.
+             * \return Estimated mean interval between occurrences, or <!--
+             * --> infinity if the element has occurred less than twice.
+             */
+            double period(const T& x, size_t time) const noexcept {
+                auto found = stamps_.find(x);
+
+                if (found == stamps_.end() || found->second.period == 0.0)
+                    return std::numeric_limits<double>::infinity();
+
+                const Stamp& stamp = found->second;
+                double elapsed = static_cast<double>(time - stamp.last);
+
+                if (elapsed <= stamp.period)
+                    return stamp.period;
+                return stamp.period + smoothing_ * (elapsed - stamp.period);
+            }
+
+            /*!
+             * \brief Forget all occurrences of an element
+             *
+             * \param x Element to forget (e.g. the id of a removed node, <!--
+             * --> which may be reused by another one).
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            IntervalEstimator& erase(const T& x) {
+                stamps_.erase(x);
+                return *this;
+            }
+
+            /*!
+             * \brief Return the time of an element's latest occurrence
+             *
+             * \param x Element whose latest occurrence is required.
+             * \return Time of latest occurrence, or 0 if it has not occurred.
+             */
+            size_t last(const T& x) const noexcept {
+                auto found = stamps_.find(x);
+
+                return found == stamps_.end() ? 0 : found->second.last;
+            }
+
+            /*!
+             * \brief Return the number of elements which have occurred
+             *
+             * \return Number of stamped elements.
+             */
+            size_t size() const noexcept {
+                return stamps_.size();
+            }
+
+            /*!
+             * \brief Print the estimated periods to an output stream.
+             *
+             * \param time Current time.
+             * \param out Output stream where the estimates are printed.
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            IntervalEstimator& print(size_t time, std::ostream& out = std::cout) {
+                out << "IntervalEstimator{"
+                    << "n=" << stamps_.size()
+                    << ", a=" << smoothing_
+                    << "}" << std::endl;
+                for (auto& stamp : stamps_)
+                    out << stamp.first << ':' << period(stamp.first, time) << '|';
+                out << std::endl;
+                return *this;
+            }
+
+        private:
+
+            /*!
+             * \struct Stamp
+             *
+             * \brief Occurrence history of a single element
+             */
+            struct Stamp {
+                size_t last;  /*!< Time of latest occurrence. */
+                double period;  /*!< Moving average of intervals (0 if unknown). */
+            };
+
+            const double smoothing_;  /*!< Weight of newest interval. */
+            std::unordered_map<T, Stamp> stamps_;  /*!< Occurrence history of each element. */
+        };  // class IntervalEstimator
+    }  // namespace heavy_hitters
+}  // namespace hmi_tree_optimization
+
+#endif  // HMI_TREE_OPTIMIZATION__HEAVY_HITTERS__INTERVAL_ESTIMATOR_HH
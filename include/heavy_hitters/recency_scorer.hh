@@ -0,0 +1,203 @@
+/*!
+ * \file include/heavy_hitters/recency_scorer.hh
+ * \brief Define a scoring engine which combines frequency and recency
+ *
+ * A count-min sketch counts the occurrences of an element over the whole
+ * lifetime of the input stream. An element which was frequent a long time ago
+ * therefore keeps a high count, whilst an element which has just become
+ * frequent takes a long time to catch up. The scorer defined below weighs each
+ * occurrence by its age instead, in the manner of the LRFU (Least Recently /
+ * Frequently Used) replacement policy, and blends the result with the
+ * sketch's lifetime frequency.
+ *
+ * \see include/heavy_hitters/cms.hh
+ *
+ * \author Petar Nikolov
+ * \version v1.0.0
+ */
+
+#ifndef HMI_TREE_OPTIMIZATION__HEAVY_HITTERS__RECENCY_SCORER_HH
+#define HMI_TREE_OPTIMIZATION__HEAVY_HITTERS__RECENCY_SCORER_HH
+
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <unordered_map>
+
+//! \namespace hmi_tree_optimization
+//! \brief Project namespace
+namespace hmi_tree_optimization {
+    //! \namespace heavy_hitters
+    //! \brief Defines data structure and the required functionality to solve the Heavy Hitters problem
+    namespace heavy_hitters {
+        /*!
+         * \class RecencyScorer
+         *
+         * \brief Scores the elements of an input stream by frequency and recency
+         *
+         * Each element keeps a combined recency and frequency value (CRF) and
+         * the time of its latest occurrence. On each occurrence the CRF decays
+         * by half for every half-life which has passed and is incremented by
+         * one. The same is done for the total mass of all occurrences, hence
+         * an element's share of the decayed mass approximates its current
+         * relative frequency.
+         *
+         * The element's score blends that share with its lifetime relative
+         * frequency (e.g. as estimated by a count-min sketch):
+         *
+         *     score = (1 - w) * crf / mass + w * frequency
+         *
+         * where w is the frequency weight. Both terms are comparable to the
+         * heavy hitter threshold 1/k.
+         *
+         * \tparam T Type of scored elements.
+         *
+         * \note The template parameter T must be hashable.
+         */
+        template<typename T>
+        class RecencyScorer final {
+
+        public:
+
+            /*!
+             * \brief Constructor for recency scorer
+             *
+             * \param half_life Time after which an occurrence weighs half as much.
+             * \param frequency_weight Weight of the lifetime relative <!--
+             * --> frequency; value is between 0 and 1.
+             */
+            explicit RecencyScorer(double half_life = 8.0, double frequency_weight = 0.25) noexcept
+                : half_life_(half_life),
+                  frequency_weight_(frequency_weight),
+                  mass_{0, 0.0} {
+            }
+
+            /*!
+             * \brief Record an occurrence of an element
+             *
+             * \param x Element which occurs.
+             * \param time Time of occurrence; must not decrease between calls.
+             * \param weight Weight of the occurrence.
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            RecencyScorer& record(const T& x, size_t time, double weight = 1.0) {
+                auto inserted = stamps_.insert(std::make_pair(x, Stamp{time, 0.0}));
+
+                bump(inserted.first->second, time, weight);
+                bump(mass_, time, weight);
+                return *this;
+            }
+
+            /*!
+             * \brief Return the score of an element
+             *
+             * \param x Scored element.
+             * \param time Current time.
+             * \param frequency Lifetime relative frequency of the element.
+             * \return Score of the element (0 if it has never occurred).
+             */
+            double score(const T& x, size_t time, double frequency) const noexcept {
+                auto found = stamps_.find(x);
+
+                if (found == stamps_.end())
+                    return 0.0;
+                return (1 - frequency_weight_) * decayed(found->second, time) / decayed(mass_, time)
+                    + frequency_weight_ * frequency;
+            }
+
+            /*!
+             * \brief Forget all occurrences of an element
+             *
+             * \param x Element to forget (e.g. the id of a removed node, <!--
+             * --> which may be reused by another one).
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            RecencyScorer& erase(const T& x) {
+                stamps_.erase(x);
+                return *this;
+            }
+
+            /*!
+             * \brief Return the time of an element's latest occurrence
+             *
+             * \param x Element whose latest occurrence is required.
+             * \return Time of latest occurrence, or 0 if it has not occurred.
+             */
+            size_t last(const T& x) const noexcept {
+                auto found = stamps_.find(x);
+
+                return found == stamps_.end() ? 0 : found->second.last;
+            }
+
+            /*!
+             * \brief Print the scorer's state to an output stream.
+             *
+             * \param time Current time.
+             * \param out Output stream where the state is printed.
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            RecencyScorer& print(size_t time, std::ostream& out = std::cout) {
+                out << "RecencyScorer{"
+                    << "n=" << stamps_.size()
+                    << ", h=" << half_life_
+                    << ", w=" << frequency_weight_
+                    << ", mass=" << decayed(mass_, time)
+                    << "}" << std::endl;
+                for (auto& stamp : stamps_)
+                    out << stamp.first << ':' << decayed(stamp.second, time) << '|';
+                out << std::endl;
+                return *this;
+            }
+
+        private:
+
+            /*!
+             * \struct Stamp
+             *
+             * \brief Decayed occurrences of a single element
+             */
+            struct Stamp {
+                size_t last;  /*!< Time of latest occurrence. */
+                double crf;  /*!< Combined recency and frequency value at that time. */
+            };
+
+            /*!
+             * \brief Decay a CRF value to a later time
+             *
+             * \param stamp Decayed occurrences.
+             * \param time Current time.
+             * \return CRF value at the current time.
+             */
+            double decayed(const Stamp& stamp, size_t time) const noexcept {
+                if (time <= stamp.last)
+                    return stamp.crf;
+                return stamp.crf * exp2(-static_cast<double>(time - stamp.last) / half_life_);
+            }
+
+            /*!
+             * \brief Add an occurrence to decayed occurrences
+             *
+             * \param stamp Decayed occurrences.
+             * \param time Time of occurrence.
+             * \param weight Weight of the occurrence.
+             */
+            void bump(Stamp& stamp, size_t time, double weight) const noexcept {
+                stamp.crf = decayed(stamp, time) + weight;
+                stamp.last = std::max(stamp.last, time);
+            }
+
+            const double half_life_;  /*!< Time after which an occurrence weighs half as much. */
+            const double frequency_weight_;  /*!< Weight of lifetime relative frequency. */
+            Stamp mass_;  /*!< Decayed occurrences of all elements. */
+            std::unordered_map<T, Stamp> stamps_;  /*!< Decayed occurrences of each element. */
+        };  // class RecencyScorer
+    }  // namespace heavy_hitters
+}  // namespace hmi_tree_optimization
+
+#endif  // HMI_TREE_OPTIMIZATION__HEAVY_HITTERS__RECENCY_SCORER_HH
@@ -12,8 +12,10 @@
 #ifndef HMI_TREE_OPTIMIZATION__SOLUTION__CACHING_HH
 #define HMI_TREE_OPTIMIZATION__SOLUTION__CACHING_HH
 
+#include <functional>
+#include <memory>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 #include "tree/hmi_tree.hh"
 #include "tree/cache_entry.hh"
@@ -24,18 +26,24 @@ namespace hmi_tree_optimization {
     //! \namespace solution 
     //! \brief Solution to the presented optimization problem
     namespace solution {
-        extern std::unordered_map<tree::nid_t, tree::CacheEntry *> g_cache_table;  /*!< Maps node ids to cache entries. */
+        extern std::unordered_map<tree::nid_t, std::shared_ptr<tree::CacheEntry>> g_cache_table;  /*!< Maps node ids to (possibly shared) cache entries. */
+
+        /*!
+         * \brief Dirtiness score of a node, given its id.
+         *
+         * The higher the score, the more likely the node is to be updated in
+         * the upcoming frames. Nodes whose score reaches a threshold are
+         * considered heavy hitters.
+         */
+        using DirtinessScore = std::function<double(tree::nid_t)>;
 
         /*!
          * \brief Evaluate the dirtiness of each tree node.
          *
          * Iterates over the whole HMI tree and decides how to mark each node.
          * They are either marked as very dirty (not fit for caching) or as
-         * very clean (fit for caching). The decision is based on the frequency
-         * of occurrence of each node.
-         *
-         * \note Whether marked as very dirty or very clean, each node has its <!--
-         * --> dirtiness state reset (i.e. it is no longer considered dirty).
+         * very clean (fit for caching). The decision is based on each node's
+         * dirtiness score, e.g. its recency-weighted frequency of occurrence.
          *
          * After the evaluation process has been complete, the program must
          * decide which nodes to actually cache.
@@ -44,10 +52,42 @@ namespace hmi_tree_optimization {
          * \see refresh_screen()
          *
          * \param tree HMI tree to evaluate.
-         * \param heavy_hitters Set of frequently updated nodes.
+         * \param score Dirtiness score of each node.
+         * \param threshold Lowest score of a heavy hitter.
+         */
+        void evaluate_tree_dirtiness(tree::HMITree& tree,
+                const DirtinessScore& score, double threshold);
+
+        /*!
+         * \brief Get the render cost of a node's shown branch.
+         *
+         * The costs are maintained while evaluating the tree's dirtiness,
+         * hence they reflect the tree as of the latest evaluation.
+         *
+         * \see evaluate_tree_dirtiness()
+         *
+         * \param node_id Id of the branch's top node.
+         *
+         * \return Cost (in node renders) of rendering the branch, or 1 if <!--
+         * --> it has not been evaluated so far.
+         */
+        double branch_cost(tree::nid_t node_id);
+
+        /*!
+         * \brief Get the weight of a node's occurrence in the frequency counts.
+         *
+         * If weighted counts are enabled (see g_weighted_counts), an
+         * occurrence weighs as much as re-rendering the node's branch, i.e.
+         * the nodes which are the most expensive to re-render become heavy
+         * hitters first. Otherwise, every occurrence weighs 1.
+         *
+         * \see branch_cost()
+         *
+         * \param node_id Id of the updated node.
+         *
+         * \return Positive weight of the occurrence.
          */
-        void evaluate_tree_dirtiness(tree::HMITree& tree, 
-                const std::unordered_set<tree::nid_t>& heavy_hitters);
+        size_t occurrence_weight(tree::nid_t node_id);
 
         /*!
          * \brief Refresh the screen.
@@ -59,6 +99,9 @@ namespace hmi_tree_optimization {
          * if any of their cached nodes become dirty. All other nodes are
          * rendered as usual.
          *
+         * \note Once the frame has been rendered, each node has its dirtiness <!--
+         * --> state reset (i.e. it is no longer considered dirty).
+         *
          * \see hmi_tree_optimization::tree::HMITree
          * \see evaluate_tree_dirtiness()
          *
@@ -66,6 +109,135 @@ namespace hmi_tree_optimization {
          */
         void refresh_screen(tree::HMITree& tree);
 
+        /*!
+         * \brief Share cache entries between structurally identical subtrees.
+         *
+         * Identical subtrees (e.g. repeated list rows) are found and grouped.
+         * The cached members of each group are made to share a single cache
+         * entry. Members which are cached later on reuse that entry instead of
+         * being rendered and cached again.
+         *
+         * A member leaves its group as soon as it (or any of its children) is
+         * updated. If its cache entry is shared, it then gets a fresh entry of
+         * its own (copy-on-write).
+         *
+         * \note Dirty subtrees (updated since the last frame) are not grouped.
+         *
+         * \see hmi_tree_optimization::tree::HMITree::find_identical_subtrees
+         *
+         * \param tree HMI tree whose subtrees are grouped.
+         *
+         * \return Number of groups of identical subtrees.
+         */
+        size_t share_identical_subtrees(tree::HMITree& tree);
+
+        /*!
+         * \brief Drop the stale cache entries of an invalidated branch.
+         *
+         * Used after a bulk change of a branch (e.g. a theme switch), instead
+         * of updating each one of its nodes. The cache entries, previous
+         * versions and placement of every node of the branch are dropped.
+         * Frequency counts are not affected.
+         *
+         * \see hmi_tree_optimization::tree::HMITree::invalidate_subtree
+         *
+         * \param top Top node of invalidated branch.
+         *
+         * \return Number of dropped cache entries.
+         */
+        size_t invalidate_branch(tree::Node& top);
+
+        /*!
+         * \brief Switch the shown page.
+         *
+         * A page is a direct child of the tree's root (usually an HMIView).
+         * Only one page is shown at a time, i.e. the first switch hides all
+         * other pages. The cache entries of hidden pages are kept, so
+         * switching back to a recently shown page loads it from the cache in
+         * a single frame.
+         *
+         * \note If the page cache is enabled (see g_page_cache_capacity), only <!--
+         * --> the most recently shown pages are kept warm. The cache entries <!--
+         * --> of less recently shown pages are dropped.
+         *
+         * \warning If the page is not a direct child of the root, an <!--
+         * --> HMIException is thrown.
+         *
+         * \param tree HMI tree whose page is switched.
+         * \param page_id Id of page to show.
+         */
+        void switch_page(tree::HMITree& tree, tree::nid_t page_id);
+
+        /*!
+         * \brief Prefetch the most likely next page.
+         *
+         * Meant to be run in idle time, between frames. Based on the observed
+         * page transitions, the page which is most likely to be switched to
+         * next is rendered and cached in advance, while it is still hidden.
+         *
+         * \note Does nothing unless the page cache can hold at least two pages.
+         *
+         * \see switch_page()
+         *
+         * \param tree HMI tree whose page is prefetched.
+         * \param score Dirtiness score of each node.
+         * \param threshold Lowest score of a heavy hitter.
+         *
+         * \return Id of prefetched page, or 0 if no page has been prefetched.
+         */
+        tree::nid_t prefetch_page(tree::HMITree& tree,
+                const DirtinessScore& score, double threshold);
+
+        /*!
+         * \brief Drop the cached state of specific nodes.
+         *
+         * Used after a layout patch. The cache entries (and versions) of
+         * removed or replaced nodes are freed, their branch statistics are
+         * dropped and the nodes leave their groups of identical subtrees.
+         * Hence, a new node which reuses one of their ids starts afresh. All
+         * other cache entries are kept.
+         *
+         * \see hmi_tree_optimization::tree::HMITree::apply_patch
+         *
+         * \param node_ids Ids of nodes whose cached state is invalid.
+         */
+        void invalidate_cache_entries(const std::vector<tree::nid_t>& node_ids);
+
+        /*!
+         * \brief Keep a node's previous cache entry as one of its versions.
+         *
+         * Heavy hitters which change among few states (e.g. a blinking
+         * indicator) restore a matching version instead of being rendered
+         * again. Besides the entry in the cache table, up to
+         * g_cache_versions - 1 versions are kept per node. The least
+         * recently used versions beyond that are freed. An entry of a branch
+         * of which a version is kept already is not kept twice. The kept
+         * version becomes the most recent one instead.
+         *
+         * \note Does nothing unless g_cache_versions is at least 2.
+         *
+         * \see take_version()
+         *
+         * \param node_id Id of the entry's node.
+         * \param entry Previous cache entry of the node.
+         */
+        void stash_version(tree::nid_t node_id, std::shared_ptr<tree::CacheEntry> entry);
+
+        /*!
+         * \brief Take a node's previous cache entry which has been built from a given branch.
+         *
+         * The taken version is no longer kept as a version, since it is
+         * meant to become the node's entry in the cache table again.
+         *
+         * \see stash_version()
+         *
+         * \param node_id Id of the entry's node.
+         * \param source_hash Subtree hash of the node's current branch.
+         *
+         * \return Matching cache entry, or null if there is none.
+         */
+        std::shared_ptr<tree::CacheEntry> take_version(tree::nid_t node_id, size_t source_hash);
+
         /*!
          * \brief Clear the cache table.
          */
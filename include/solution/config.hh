@@ -11,6 +11,8 @@
 #ifndef HMI_TREE_OPTIMIZATION__TREE__CONFIG_HH
 #define HMI_TREE_OPTIMIZATION__TREE__CONFIG_HH
 
+#include <cstddef>
+
 //! \namespace hmi_tree_optimization
 //! \brief Project namespace
 namespace hmi_tree_optimization {
@@ -18,6 +20,17 @@ namespace hmi_tree_optimization {
     //! \brief Solution to the presented optimization problem
     namespace solution {
         extern bool g_debug;  /*!< Display debug messages. */
+        extern double g_hot_period;  /*!< Longest update period (in frames) of a heavy hitter which is not cached. */
+        extern double g_recency_half_life;  /*!< Number of frames after which an occurrence weighs half as much in dirtiness scores. */
+        extern double g_frequency_weight;  /*!< Weight of lifetime frequency (vs. recency-weighted frequency) in dirtiness scores. */
+        extern double g_cache_load_cost;  /*!< Cost of loading a cache entry, relative to rendering a node. */
+        extern double g_cache_store_cost;  /*!< Cost of storing a cache entry, relative to rendering a node. */
+        extern size_t g_cache_budget;  /*!< Memory budget (in bytes) of cached branches (0 disables the budgeted placement). */
+        extern double g_node_entry_size;  /*!< Assumed size (in bytes) of a cache entry as long as none has been measured. */
+        extern size_t g_placement_period;  /*!< Number of frames between two placements of cached branches under the budget. */
+        extern bool g_weighted_counts;  /*!< Weigh each node's occurrence by the render cost of its branch (off by default). */
+        extern size_t g_cache_versions;  /*!< Number of cache entry versions kept per heavy hitter (1, the default, disables versions). */
+        extern size_t g_page_cache_capacity;  /*!< Number of recently shown pages kept warm (2 by default, 0 disables the page cache). */
     }  // namespace solution 
 }  // namespace hmi_tree_optimization
 
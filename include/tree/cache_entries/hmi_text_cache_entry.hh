@@ -18,6 +18,7 @@
 #include <string>
 
 #include "tree/cache_entry.hh"
+#include "tree/string_table.hh"
 
 //! \namespace hmi_tree_optimization
 //! \brief Project namespace
@@ -31,7 +32,7 @@ namespace hmi_tree_optimization {
          * \brief Cache entry for HMIText nodes.
          *
          * This cache entry stores the following information from HMIText:
-         * - "content_": std::string
+         * - "content_": sid_t (id of the interned text content)
          *
          * \see CacheEntry
          * \see HMIText
@@ -43,15 +44,35 @@ namespace hmi_tree_optimization {
             /*!
              * \brief Create HMIText cache entry.
              *
-             * \param content Reference to 'content_' attribute of an HMIText node.
+             * \param content Value of 'content_' attribute of an HMIText node.
              */
-            explicit HMITextCacheEntry(const std::string& content);
+            explicit HMITextCacheEntry(sid_t content);
 
             /*!
              * \brief Destroy HMIText cache entry.
              */
             ~HMITextCacheEntry() noexcept;
 
+            /*!
+             * \brief Overwrite the cached 'content_' attribute.
+             *
+             * \param content Value of 'content_' attribute of an HMIText node.
+             *
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            HMITextCacheEntry& assign(sid_t content);
+
+            /*!
+             * \brief Estimate the memory taken up by this HMITextCacheEntry.
+             *
+             * \see CacheEntry::size
+             *
+             * \return Approximate size of the entry (in bytes).
+             */
+            size_t size() const noexcept final;
+
             /*!
              * \brief Return a detailed string representation of this HMITextCacheEntry.
              *
@@ -18,6 +18,8 @@
 #include <string>
 #include <unordered_map>
 
+#include "tree/memory_pool.hh"
+
 //! \namespace hmi_tree_optimization
 //! \brief Project namespace
 namespace hmi_tree_optimization {
@@ -47,6 +49,31 @@ namespace hmi_tree_optimization {
 
         public:
 
+            /*!
+             * \brief Construct cache entry.
+             */
+            CacheEntry() noexcept;
+
+            /*!
+             * \brief Get the hash of the branch which the entry has been built from.
+             *
+             * \see Node::subtree_hash
+             *
+             * \return Subtree hash of cached branch.
+             */
+            size_t get_source_hash() const noexcept;
+
+            /*!
+             * \brief Record the hash of the branch which the entry is built from.
+             *
+             * \param source_hash Subtree hash of cached branch.
+             *
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            CacheEntry& set_source_hash(size_t source_hash) noexcept;
+
             /*!
              * \brief Get map of attribute values copies.
              *
@@ -56,11 +83,51 @@ namespace hmi_tree_optimization {
              */
             const std::unordered_map<std::string, void *>& get_attributes() const noexcept;
 
+            /*!
+             * \brief Estimate the memory taken up by this cache entry.
+             *
+             * \details This method may be overridden by a CacheEntry <!--
+             * --> subclass which stores more than the attribute map.
+             *
+             * \return Approximate size of the entry (in bytes).
+             */
+            virtual size_t size() const noexcept;
+
             /*!
              * \brief Destroy cache entry.
              */
             virtual ~CacheEntry() noexcept;
 
+            /*!
+             * \brief Allocate memory for a cache entry from the cache entry pool
+             *
+             * \see CacheEntry::pool
+             *
+             * \param size Size of the allocated cache entry's type.
+             *
+             * \return Pointer to allocated memory.
+             */
+            static void *operator new(size_t size);
+
+            /*!
+             * \brief Return a cache entry's memory to the cache entry pool
+             *
+             * \see CacheEntry::pool
+             *
+             * \param ptr Pointer to memory of a destroyed cache entry.
+             * \param size Size of the destroyed cache entry's type.
+             */
+            static void operator delete(void *ptr, size_t size) noexcept;
+
+            /*!
+             * \brief Access the memory pool which serves all cache entries
+             *
+             * \see MemoryPool
+             *
+             * \return Cache entry memory pool.
+             */
+            static MemoryPool& pool();
+
             /*!
              * \brief Return a detailed string representation of this CacheEntry.
              *
@@ -82,6 +149,7 @@ namespace hmi_tree_optimization {
         private:
 
             std::unordered_map<std::string, void *> attributes_;  /*!< Map of attribute values copies. */
+            size_t source_hash_;  /*!< Subtree hash of the branch which the entry has been built from. */
         };  // class CacheEntry
     }  // namespace tree
 }  // namespace hmi_tree_optimization
@@ -24,6 +24,7 @@
 
 #include "tree/node.hh"
 #include "tree/cache_entry.hh"
+#include "tree/string_table.hh"
 
 //! \namespace hmi_tree_optimization
 //! \brief Project namespace
@@ -40,10 +41,17 @@ namespace hmi_tree_optimization {
          * they are meant to represent the leaf nodes of an HMI tree. Therefore,
          * it is not recommended to attach any child nodes to these text ones.
          *
+         * The text content itself is interned in a string table shared by all
+         * text nodes. Each node (and its cache entry) only holds the content's
+         * id along with a reference to it, which is given back once the node
+         * (or the cache entry) is destroyed or refers to another content.
+         *
+         * \see StringTable
+         *
          * \see Node
          */
         class HMIText final: public Node {
-            
+
         public:
 
             /*!
@@ -52,7 +60,27 @@ namespace hmi_tree_optimization {
              * \param id The node's assigned id.
              * \param content Text content of node.
              */
-            explicit HMIText(nid_t id, const std::string& content) noexcept;
+            explicit HMIText(nid_t id, const std::string& content);
+
+            /*!
+             * \brief Destroy HMI text node
+             *
+             * \note The reference to the interned content is released.
+             */
+            ~HMIText() noexcept;
+
+            /*!
+             * \brief Access the string table which interns all text contents
+             *
+             * \see StringTable
+             *
+             * \return Text content string table.
+             *
+             * \warning Like the memory pools, the table is a function-local <!--
+             * --> static, hence every text node and text cache entry must <!--
+             * --> have been destroyed before it at exit.
+             */
+            static StringTable& strings();
 
             /*!
              * \brief Return a string representation of this HMI text 
@@ -87,7 +115,16 @@ namespace hmi_tree_optimization {
              *
              * \return Text content of this node.
              */
-            const std::string& get_content() const noexcept;
+            const std::string& get_content() const;
+
+            /*!
+             * \brief Get id of the interned text content of HMI text node
+             *
+             * \see HMIText::strings
+             *
+             * \return Id of the text content of this node.
+             */
+            sid_t get_content_id() const noexcept;
 
             /*!
              * \brief Set text content of HMI text node
@@ -98,11 +135,19 @@ namespace hmi_tree_optimization {
              *
              * \remark The returned reference to this may be used for method chaining.
              */
-            HMIText& set_content(const std::string& content) noexcept;
+            HMIText& set_content(const std::string& content);
 
         private:
 
-            std::string content_;  /*!< Text content of node. */
+            /*!
+             * \brief Construct HMI text node from interned content
+             *
+             * \param id The node's assigned id.
+             * \param content Id of interned text content of node.
+             */
+            explicit HMIText(nid_t id, sid_t content) noexcept;
+
+            sid_t content_;  /*!< Id of interned text content of node. */
 
             /*!
              * \brief Apply update parameters to this HMI text
@@ -113,6 +158,17 @@ namespace hmi_tree_optimization {
              */
             void apply_update(const std::vector<std::string>& parameters) final;
 
+            /*!
+             * \brief Check whether update parameters differ from the text's state
+             *
+             * \see Node::is_changed_by
+             *
+             * \param parameters String parameters of update.
+             *
+             * \return True if applying the update would change the text.
+             */
+            bool is_changed_by(const std::vector<std::string>& parameters) const final;
+
             /*!
              * \brief Generate an HMI text cache entry
              *
@@ -130,6 +186,35 @@ namespace hmi_tree_optimization {
              * \param entry Cached HMI text state which is to be restored.
              */
             void use_cache_entry(const CacheEntry *entry) final;
+
+            /*!
+             * \brief Overwrite a cache entry with the text's current state
+             *
+             * \see Node::update_cache_entry
+             *
+             * \param entry Cached HMI text state which is overwritten.
+             */
+            void update_cache_entry(CacheEntry& entry) final;
+
+            /*!
+             * \brief Hash the text's own content
+             *
+             * \see Node::hash_content
+             *
+             * \return Hash of the text's content.
+             */
+            size_t hash_content() const noexcept final;
+
+            /*!
+             * \brief Create a detached copy of this text
+             *
+             * \see Node::clone_node
+             *
+             * \param id The copy's assigned id.
+             *
+             * \return Pointer to copy of this text.
+             */
+            Node *clone_node(nid_t id) const final;
         };  // class HMIText
     }  // namespace tree
 }  // namespace hmi_tree_optimization
@@ -99,6 +99,17 @@ namespace hmi_tree_optimization {
              */
             void apply_update(const std::vector<std::string>& parameters) final;
 
+            /*!
+             * \brief Check whether update parameters differ from the view's state
+             *
+             * \see Node::is_changed_by
+             *
+             * \param parameters String parameters of update.
+             *
+             * \return True if applying the update would change the view.
+             */
+            bool is_changed_by(const std::vector<std::string>& parameters) const final;
+
             /*!
              * \brief Generate an HMI view cache entry
              *
@@ -116,6 +127,35 @@ namespace hmi_tree_optimization {
              * \param entry Cached HMI view state which is to be restored.
              */
             void use_cache_entry(const CacheEntry *entry) final;
+
+            /*!
+             * \brief Overwrite a cache entry with the view's current state
+             *
+             * \see Node::update_cache_entry
+             *
+             * \param entry Cached HMI view state which is overwritten.
+             */
+            void update_cache_entry(CacheEntry& entry) final;
+
+            /*!
+             * \brief Hash the view's own content
+             *
+             * \see Node::hash_content
+             *
+             * \return Hash of the view's content.
+             */
+            size_t hash_content() const noexcept final;
+
+            /*!
+             * \brief Create a detached copy of this view
+             *
+             * \see Node::clone_node
+             *
+             * \param id The copy's assigned id.
+             *
+             * \return Pointer to copy of this view.
+             */
+            Node *clone_node(nid_t id) const final;
         };  // class HMIView
     }  // namespace tree
 }  // namespace hmi_tree_optimization
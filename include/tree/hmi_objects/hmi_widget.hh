@@ -89,6 +89,17 @@ namespace hmi_tree_optimization {
              */
             void apply_update(const std::vector<std::string>& parameters) final;
 
+            /*!
+             * \brief Check whether update parameters differ from the widget's state
+             *
+             * \see Node::is_changed_by
+             *
+             * \param parameters String parameters of update.
+             *
+             * \return True if applying the update would change the widget.
+             */
+            bool is_changed_by(const std::vector<std::string>& parameters) const final;
+
             /*!
              * \brief Generate an HMI widget cache entry
              *
@@ -106,6 +117,35 @@ namespace hmi_tree_optimization {
              * \param entry Cached HMI widget state which is to be restored.
              */
             void use_cache_entry(const CacheEntry *entry) final;
+
+            /*!
+             * \brief Overwrite a cache entry with the widget's current state
+             *
+             * \see Node::update_cache_entry
+             *
+             * \param entry Cached HMI widget state which is overwritten.
+             */
+            void update_cache_entry(CacheEntry& entry) final;
+
+            /*!
+             * \brief Hash the widget's own content
+             *
+             * \see Node::hash_content
+             *
+             * \return Hash of the widget's content.
+             */
+            size_t hash_content() const noexcept final;
+
+            /*!
+             * \brief Create a detached copy of this widget
+             *
+             * \see Node::clone_node
+             *
+             * \param id The copy's assigned id.
+             *
+             * \return Pointer to copy of this widget.
+             */
+            Node *clone_node(nid_t id) const final;
         };  // class HMIWidget
     }  // namespace tree
 }  // namespace hmi_tree_optimization
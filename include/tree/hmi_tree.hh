@@ -18,8 +18,14 @@
 #define HMI_TREE_OPTIMIZATION__TREE__HMI_TREE_HH
 
 #include <iostream>
-#include <unordered_set>
+#include <memory>
+#include <set>
+#include <string>
 #include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "tree/node.hh"
 #include "tree/hmi_objects/hmi_view.hh"
@@ -30,6 +36,59 @@ namespace hmi_tree_optimization {
     //! \namespace tree
     //! \brief Contains a bare bones simulated HMI tree
     namespace tree {
+        /*!
+         * \struct NodeRecord
+         *
+         * \brief Description of a single node to be built into an HMI tree
+         *
+         * \note References to existing branches are not described via <!--
+         * --> records. They are added via HMITree::add_reference.
+         *
+         * The node type is given by its letter ('W' for HMIWidget, 'T' for
+         * HMIText). The additional arguments depend on the node type (e.g. an
+         * HMIText expects its content as its first argument).
+         *
+         * \see HMITree::build
+         */
+        struct NodeRecord {
+            nid_t parent_id;  /*!< Id of the node's parent. */
+            char type;  /*!< Letter of the node's type. */
+            nid_t id;  /*!< Id of the node. */
+            std::vector<std::string> args;  /*!< Additional type dependent arguments. */
+        };
+
+        /*!
+         * \struct PatchOperation
+         *
+         * \brief Single structural change of an HMI tree's layout
+         *
+         * Depending on the kind of operation, only some of the node record's
+         * fields are used:
+         * - \b add: all of them (a new node is created, as if it was built);
+         * - \b remove: the id of the node whose branch is removed;
+         * - \b move: the id of the moved node and the id of its new parent;
+         * - \b retype: the id of the node which is replaced, its new type and
+         *   its new arguments (the node keeps its id, parents and children).
+         *
+         * \see HMITree::apply_patch
+         */
+        struct PatchOperation {
+            /*!
+             * \enum PatchOperation::Kind
+             *
+             * \brief Kind of structural change
+             */
+            enum class Kind : unsigned char {
+                add,  /*!< Create a new node. */
+                remove,  /*!< Remove a node's branch. */
+                move,  /*!< Move a node's branch to another parent. */
+                retype  /*!< Replace a node by one of another type. */
+            };
+
+            Kind kind;  /*!< Kind of structural change. */
+            NodeRecord node;  /*!< Description of the changed node. */
+        };
+
         /*!
          * \class HMITree
          *
@@ -41,11 +100,20 @@ namespace hmi_tree_optimization {
          * of Node should not be stored and manipulated within the optimization
          * algorithm's codebase).
          *
+         * The tree keeps an index of its nodes by id, which is updated by
+         * each of its methods which adds or removes nodes. Nodes which are
+         * linked to each other directly (via Node::add_child) are not indexed.
+         *
          * Also, The HMITree can be iterated over via the use of iterators.
          * Two different types of tree traversals are implemented - DFS and BFS
          * respectively implemented via the HMITree::dfs_iterator and
          * HMITree::bfs_iterator classes.
          *
+         * Strictly speaking, the HMI tree is a directed acyclic graph: besides
+         * its own parent, a branch may be referenced by any number of other
+         * nodes (e.g. the same gauge shown on two screens). Such a shared
+         * branch is stored only once and each traversal visits it only once.
+         *
          * \see Node
          * \see HMITree::dfs_iterator
          * \see HMITree::bfs_iterator
@@ -283,7 +351,10 @@ namespace hmi_tree_optimization {
              *
              * \note The root node is always initialized with an id of '0'.
              */
-            explicit HMITree() noexcept;
+            explicit HMITree();
+
+            HMITree(const HMITree&) = delete;
+            HMITree& operator=(const HMITree&) = delete;
 
             /*!
              * \brief Attach a new child node to one of the tree's other existing nodes
@@ -361,6 +432,255 @@ namespace hmi_tree_optimization {
              */
             HMITree& add_node(const Node& parent_node, Node& node);
 
+            /*!
+             * \brief Create and attach many new nodes to the tree at once
+             *
+             * Each record's parent may either be an existing tree node or any
+             * other record's node, regardless of the order of the records.
+             * The whole operation takes time linear in the number of records
+             * (whereas adding nodes one by one via HMITree::add_node takes <!--
+             * --> time linear in the size of the tree per node).
+             *
+             * \note If any record is invalid (unknown type, missing <!--
+             * --> arguments, already leased id, unknown parent or a parent <!--
+             * --> cycle), an HMIException is thrown and the tree is left <!--
+             * --> unchanged.
+             *
+             * \see NodeRecord
+             *
+             * \param records Descriptions of nodes to create.
+             *
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            HMITree& build(const std::vector<NodeRecord>& records);
+
+            /*!
+             * \brief Apply a structural diff to the tree's layout
+             *
+             * The operations are applied in order. Only the parents which
+             * gain or lose children (and the retyped nodes) are marked as
+             * dirty, so that their ancestors' cached state is refreshed. All
+             * other branches are left untouched.
+             *
+             * The ids of all removed nodes are released.
+             *
+             * \note If an operation is invalid (unknown node or parent, <!--
+             * --> leased id, removing, moving or retyping the root or a <!--
+             * --> node referenced by a parent unknown to the tree, moving <!--
+             * --> a branch into itself), an HMIException is thrown. The <!--
+             * --> operations preceding it remain applied.
+             *
+             * \see PatchOperation
+             *
+             * \param operations Structural changes to apply.
+             *
+             * \return Ids of all nodes which have been removed or replaced <!--
+             * --> (i.e. whose cached state is no longer valid).
+             */
+            std::vector<nid_t> apply_patch(const std::vector<PatchOperation>& operations);
+
+            /*!
+             * \brief Reference an existing branch from another node
+             *
+             * The target node (alongside its whole branch) becomes a child of
+             * the given parent node as well. It is not copied, i.e. the branch
+             * is shared by all of its parents.
+             *
+             * \note If either node is not found, the target is the root or <!--
+             * --> the reference would create a cycle, an HMIException is thrown.
+             *
+             * \param parent_id Node id of referencing tree node.
+             * \param target_id Node id of referenced tree node.
+             *
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            HMITree& add_reference(nid_t parent_id, nid_t target_id);
+
+            /*!
+             * \brief Show or hide an existing tree node (alongside its branch)
+             *
+             * \note If node is not found, a HMIException is thrown.
+             *
+             * \see Node::set_visible
+             *
+             * \param id ID of shown or hidden node.
+             * \param visible Whether the node should be visible.
+             *
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            HMITree& set_visibility(nid_t id, bool visible);
+
+            /*!
+             * \brief Mark a whole branch for re-rendering
+             *
+             * Meant for changes which affect every node of a branch at once
+             * (e.g. a theme, language or unit switch). The revision of every
+             * node of the branch is bumped, so that none of their cache
+             * entries (or previous versions) match any more. Only the top node
+             * is marked as dirty, so that its cached ancestors are refreshed.
+             * Unlike an update, this is not an occurrence of any node and
+             * should not be counted as such.
+             *
+             * \note If node is not found, a HMIException is thrown.
+             *
+             * \see hmi_tree_optimization::solution::invalidate_branch
+             *
+             * \param id ID of top node of invalidated branch.
+             *
+             * \return Top node of invalidated branch, whose stale cache <!--
+             * --> entries are still to be dropped by the cache layer.
+             */
+            Node& invalidate_subtree(nid_t id);
+
+            /*!
+             * \brief Begin a transaction of updates
+             *
+             * Until the transaction is committed, updates are only staged.
+             * Related updates (e.g. a song's title, artist and album) are
+             * therefore never rendered half applied, even if a frame is
+             * refreshed in between.
+             *
+             * \note If a transaction has already begun, an HMIException is thrown.
+             *
+             * \see HMITree::stage_update
+             * \see HMITree::commit
+             *
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            HMITree& begin();
+
+            /*!
+             * \brief Check whether a transaction of updates has begun
+             *
+             * \return True if updates are being staged. False otherwise.
+             */
+            bool in_transaction() const noexcept;
+
+            /*!
+             * \brief Stage an update of an existing tree node
+             *
+             * \note If no transaction has begun or if the node is not found, <!--
+             * --> an HMIException is thrown.
+             *
+             * \see Node::update
+             *
+             * \param id ID of updated node.
+             * \param parameters Update parameters (depend on the node's type).
+             *
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            HMITree& stage_update(nid_t id, const std::vector<std::string>& parameters);
+
+            /*!
+             * \brief Commit a transaction of updates
+             *
+             * All staged updates are applied at once, in the order in which
+             * they have been staged.
+             *
+             * \note If no transaction has begun or if a staged node has been <!--
+             * --> removed in the meantime, an HMIException is thrown. In the <!--
+             * --> latter case none of the updates is applied and the <!--
+             * --> transaction stays open.
+             *
+             * \see HMITree::begin
+             *
+             * \return Ids of updated nodes which have not been dirty before <!--
+             * --> (each one listed once).
+             */
+            std::vector<nid_t> commit();
+
+            /*!
+             * \brief Register an existing branch as a named prototype
+             *
+             * A detached copy of the branch is stored in the tree. The branch
+             * itself may be freely modified or removed afterwards. Registering
+             * another prototype of the same name replaces the previous one.
+             *
+             * \note If the node is not found, an HMIException is thrown.
+             *
+             * \see HMITree::instantiate
+             *
+             * \param name Name of prototype.
+             * \param top_id Node id of the branch's top node.
+             *
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            HMITree& register_prototype(const std::string& name, nid_t top_id);
+
+            /*!
+             * \brief Check whether a prototype has been registered
+             *
+             * \param name Name of prototype.
+             *
+             * \return True if the prototype has been registered. False otherwise.
+             */
+            bool has_prototype(const std::string& name) const noexcept;
+
+            /*!
+             * \brief Attach a new copy of a prototype to an existing tree node
+             *
+             * Each node of the copy is assigned a freshly leased id. The new
+             * branch's top node is marked as dirty.
+             *
+             * \note If the prototype or the parent node is not found, an <!--
+             * --> HMIException is thrown.
+             *
+             * \see HMITree::register_prototype
+             * \see HMITree::lease_free_nid
+             *
+             * \param name Name of prototype.
+             * \param parent_id Node id of existing tree node.
+             *
+             * \return Node id of the new branch's top node.
+             */
+            nid_t instantiate(const std::string& name, nid_t parent_id);
+
+            /*!
+             * \brief Attach a new copy of a prototype to an existing tree node
+             *
+             * \note If the prototype is not found, an HMIException is thrown.
+             *
+             * \see HMITree::register_prototype
+             * \see HMITree::lease_free_nid
+             *
+             * \param name Name of prototype.
+             * \param parent Reference to existing tree parent node.
+             *
+             * \return Node id of the new branch's top node.
+             */
+            nid_t instantiate(const std::string& name, Node& parent);
+
+            /*!
+             * \brief Find groups of structurally identical subtrees
+             *
+             * Two subtrees are identical if their top nodes are of the same
+             * type, have the same content and if their children can be paired
+             * into identical subtrees (regardless of their order). Node ids
+             * are not taken into account.
+             *
+             * \details Each subtree is assigned a canonical class in a single <!--
+             * --> bottom-up pass (hash consing), i.e. the search takes time <!--
+             * --> linear in the size of the tree.
+             *
+             * \see Node::content_hash
+             *
+             * \return Groups of ids of identical subtrees' top nodes. Each <!--
+             * --> group holds at least two ids. The root is never included.
+             */
+            std::vector<std::vector<nid_t>> find_identical_subtrees() const;
+
             /*!
              * \brief Provide access to an existing tree node.
              *
@@ -402,14 +722,37 @@ namespace hmi_tree_optimization {
              *
              * The caller may optionally specify a preferred id to be leased
              * for a node. If it is available (not already taken), the given
-             * id is leased and returned. Otherwise, a random node id is
-             * generated and returned to the caller.
+             * id is leased and returned. Otherwise, the most recently released
+             * id is reused. If there is none, the lowest id which has never
+             * been leased is returned to the caller.
+             *
+             * \details Leasing an id takes amortized constant time and is <!--
+             * --> deterministic. Only far outlier ids (more than 65536 <!--
+             * --> beyond the highest dense id) take logarithmic time.
              * 
              * \param preferred_id Preferred id to lease if it hasn't already been taken.
              *
              * \return Available leased node id.
              */
-            nid_t lease_free_nid(nid_t preferred_id = 0) noexcept;
+            nid_t lease_free_nid(nid_t preferred_id = 0);
+
+            /*!
+             * \brief Release a leased node id so that it may be leased again.
+             *
+             * \note Releasing an id which is not leased has no effect.
+             *
+             * \param id Leased node id to release.
+             */
+            void release_nid(nid_t id) noexcept;
+
+            /*!
+             * \brief Check whether a node id is leased.
+             *
+             * \param id Node id to check.
+             *
+             * \return True if the node id is leased. False otherwise.
+             */
+            bool is_nid_leased(nid_t id) const noexcept;
 
             /*!
              * \brief Begin DFS iteration. Get iterator to first element.
@@ -459,9 +802,41 @@ namespace hmi_tree_optimization {
 
         private:
 
+            /*!
+             * \brief Index a new branch of the tree by its nodes' ids
+             *
+             * \param top Top node of new branch.
+             */
+            void index_branch(Node& top);
+
+            /*!
+             * \struct HMITree::Prototype
+             *
+             * \brief Detached copy of a branch which can be instantiated
+             *
+             * The copied nodes are stored in a flat array (the branch's top
+             * node first) and their parent-child relations as pairs of indices
+             * into it. A shared branch is stored once and linked to each of
+             * its parents.
+             */
+            struct Prototype {
+                std::vector<std::unique_ptr<Node>> nodes;  /*!< Detached node copies (top node first). */
+                std::vector<std::pair<size_t, size_t>> links;  /*!< Parent and child indices of each relation. */
+            };
+
+            static constexpr nid_t max_dense_gap = 1 << 16;  /*!< Farthest an id may lie beyond the bitmap to extend it. */
+
             HMIView root_;  /*!< Root node of HMI tree. */
-            std::unordered_set<nid_t> id_pool_;  /*!< Pool of leased node ids. */
+            std::vector<bool> leased_ids_;  /*!< Occupancy bitmap of leased node ids. */
+            std::set<nid_t> sparse_leased_ids_;  /*!< Leased ids too far beyond the bitmap to be stored in it (lowest first). */
+            std::vector<nid_t> released_ids_;  /*!< Released ids to be leased again (last released on top). */
+            nid_t next_nid_;  /*!< Lowest node id which has never been leased. */
             std::deque<Node *> it_container_;  /*!< DFS and BFS iteration data structure. */
+            std::unordered_set<const Node *> it_visited_;  /*!< Shared nodes (with several parents) reached by current DFS or BFS iteration. */
+            std::unordered_map<nid_t, Node *> index_;  /*!< Maps ids to the nodes attached via the tree's own methods. */
+            std::unordered_map<std::string, Prototype> prototypes_;  /*!< Registered prototypes by name. */
+            bool in_transaction_;  /*!< Indicates whether updates are being staged. */
+            std::vector<std::pair<nid_t, std::vector<std::string>>> staged_updates_;  /*!< Staged node ids and update parameters. */
         };  // class HMITree
 
         /*!
@@ -0,0 +1,178 @@
+/*!
+ * \file include/tree/memory_pool.hh
+ * \brief Definition of a size-class memory pool for tree objects
+ *
+ * HMI tree nodes and cache entries are small, short-lived objects which are
+ * created and destroyed continuously throughout the lifetime of the system.
+ * Allocating each one of them separately on the heap fragments the latter.
+ * The memory pool, defined in this file, serves such objects from large
+ * preallocated chunks and recycles freed blocks, so that a steady stream of
+ * allocations and deallocations does not request any new memory.
+ *
+ * \see src/tree/memory_pool.cc
+ *
+ * \author Petar Nikolov
+ * \version v1.0.0
+ */
+
+#ifndef HMI_TREE_OPTIMIZATION__TREE__MEMORY_POOL_HH
+#define HMI_TREE_OPTIMIZATION__TREE__MEMORY_POOL_HH
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//! \namespace hmi_tree_optimization
+//! \brief Project namespace
+namespace hmi_tree_optimization {
+    //! \namespace tree
+    //! \brief Contains a bare bones simulated HMI tree
+    namespace tree {
+        /*!
+         * \class MemoryPool
+         *
+         * \brief Size-class pool allocator
+         *
+         * Every requested size is rounded up to a multiple of the pool's
+         * granularity which determines the block's size class. Each size class
+         * has its own free list of blocks. If the free list of a size class is
+         * empty, a new chunk of memory is requested from the heap and split
+         * into several blocks of that size class. Freed blocks are pushed back
+         * onto their free list and are reused by subsequent allocations.
+         * Chunks are only released when the pool itself is destroyed.
+         *
+         * Requests which exceed the largest size class are forwarded directly
+         * to the global allocation functions.
+         *
+         * \note The pool is not thread-safe.
+         *
+         * \warning The pools of Node and CacheEntry are function-local statics
+         * which are created on first use, i.e. after the global cache table
+         * of the solution. Hence, they are destroyed before it at exit and
+         * every pooled object must have been freed by then. This only holds
+         * because the solution's main routine calls clear_cache() before it
+         * returns.
+         */
+        class MemoryPool final {
+
+        public:
+
+            /*!
+             * \brief Construct memory pool
+             *
+             * \param name Name of pool (displayed when printing the pool).
+             * \param nblocks_per_chunk Number of blocks to carve out of each <!--
+             * --> newly requested chunk of memory.
+             */
+            explicit MemoryPool(const std::string& name,
+                    size_t nblocks_per_chunk = 256);
+
+            /*!
+             * \brief Destroy memory pool and release all chunks
+             *
+             * \warning All blocks, which have been allocated by the pool, <!--
+             * --> become invalid.
+             */
+            ~MemoryPool() noexcept;
+
+            MemoryPool(const MemoryPool&) = delete;
+            MemoryPool& operator=(const MemoryPool&) = delete;
+
+            /*!
+             * \brief Allocate a block of memory
+             *
+             * \param size Number of requested bytes.
+             *
+             * \return Pointer to allocated block.
+             */
+            void *allocate(size_t size);
+
+            /*!
+             * \brief Return a block of memory to the pool
+             *
+             * \param ptr Pointer to a block, previously allocated by this pool.
+             * \param size Number of bytes requested when allocating the block.
+             */
+            void deallocate(void *ptr, size_t size) noexcept;
+
+            /*!
+             * \brief Get the number of chunks requested from the heap
+             *
+             * \return Number of chunks.
+             */
+            size_t nchunks() const noexcept;
+
+            /*!
+             * \brief Get the number of blocks currently in use
+             *
+             * \return Number of allocated blocks which have not been freed.
+             */
+            size_t nlive_blocks() const noexcept;
+
+            /*!
+             * \brief Get the number of requests forwarded to the heap
+             *
+             * \return Number of allocations which exceeded the largest size class.
+             */
+            size_t noversized() const noexcept;
+
+            /*!
+             * \brief Get the amount of memory reserved by the pool
+             *
+             * \return Number of reserved bytes (in all chunks).
+             */
+            size_t nreserved_bytes() const noexcept;
+
+            /*!
+             * \brief Print the pool's statistics to an output stream.
+             *
+             * \param out Output stream where the pool is printed.
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            MemoryPool& print(std::ostream& out = std::cout) noexcept;
+
+        private:
+
+            /*!
+             * \struct MemoryPool::FreeBlock
+             *
+             * \brief Header of an unused block, linking it to the next free block.
+             */
+            struct FreeBlock {
+                FreeBlock *next;  /*!< Next free block of the same size class. */
+            };
+
+            static constexpr size_t granularity = 16;  /*!< Size difference between two size classes. */
+            static constexpr size_t nsize_classes = 16;  /*!< Number of size classes. */
+            const std::string name_;  /*!< Name of pool. */
+            const size_t nblocks_per_chunk_;  /*!< Number of blocks per chunk. */
+            std::vector<FreeBlock *> free_lists_;  /*!< Free list of each size class. */
+            std::vector<void *> chunks_;  /*!< Chunks requested from the heap. */
+            size_t nlive_blocks_;  /*!< Number of blocks in use. */
+            size_t noversized_;  /*!< Number of requests forwarded to the heap (never decreases). */
+            size_t nreserved_bytes_;  /*!< Number of bytes in all chunks. */
+
+            /*!
+             * \brief Find the size class of a requested size
+             *
+             * \param size Number of requested bytes.
+             *
+             * \return Index of size class. Equal to MemoryPool::nsize_classes <!--
+             * --> if the size exceeds the largest size class.
+             */
+            static size_t size_class(size_t size) noexcept;
+
+            /*!
+             * \brief Request a new chunk and split it into free blocks
+             *
+             * \param sclass Size class of the blocks in the new chunk.
+             */
+            void grow(size_t sclass);
+        };  // class MemoryPool
+    }  // namespace tree
+}  // namespace hmi_tree_optimization
+
+#endif  // HMI_TREE_OPTIMIZATION__TREE__MEMORY_POOL_HH
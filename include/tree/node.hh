@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "tree/cache_entry.hh"
+#include "tree/memory_pool.hh"
 
 //! \namespace hmi_tree_optimization
 //! \brief Project namespace
@@ -65,6 +66,36 @@ namespace hmi_tree_optimization {
              */
             virtual ~Node() noexcept;
 
+            /*!
+             * \brief Allocate memory for a node from the node pool
+             *
+             * \see Node::pool
+             *
+             * \param size Size of the allocated node's type.
+             *
+             * \return Pointer to allocated memory.
+             */
+            static void *operator new(size_t size);
+
+            /*!
+             * \brief Return a node's memory to the node pool
+             *
+             * \see Node::pool
+             *
+             * \param ptr Pointer to memory of a destroyed node.
+             * \param size Size of the destroyed node's type.
+             */
+            static void operator delete(void *ptr, size_t size) noexcept;
+
+            /*!
+             * \brief Access the memory pool which serves all dynamically allocated nodes
+             *
+             * \see MemoryPool
+             *
+             * \return Node memory pool.
+             */
+            static MemoryPool& pool();
+
             /*!
              * \brief Get the node's assigned id
              *
@@ -254,6 +285,69 @@ namespace hmi_tree_optimization {
              */
             bool is_dirty() const noexcept;
 
+            /*!
+             * \brief Check if any (direct or indirect) child node is dirty
+             *
+             * When a node is updated, this state is propagated upwards through
+             * all of its parents, i.e. through every branch which references
+             * the updated node.
+             *
+             * \see Node::update
+             *
+             * \return True if a descendant node is dirty. False otherwise.
+             */
+            bool has_dirty_descendants() const noexcept;
+
+            /*!
+             * \brief Check if node is visible
+             *
+             * A hidden node (alongside its whole branch) is neither evaluated
+             * nor rendered. Its updates do not affect its parents.
+             *
+             * \return True if node is visible. False otherwise.
+             */
+            bool is_visible() const noexcept;
+
+            /*!
+             * \brief Check if node is shown on the screen
+             *
+             * A node is shown if it is visible and if it is either a top node
+             * (e.g. the root) or at least one of its parents is shown.
+             *
+             * \note The result is cached until the visibility or the parents <!--
+             * --> of any node change.
+             *
+             * \return True if node is shown. False otherwise.
+             */
+            bool is_shown() const noexcept;
+
+            /*!
+             * \brief Get the current visibility epoch
+             *
+             * The epoch grows whenever the visibility or the parents of any
+             * node change. Callers may keep state derived from the shown
+             * nodes as long as the epoch stays the same.
+             *
+             * \return Number of changes to any node's visibility or parents.
+             */
+            static size_t get_visibility_epoch() noexcept;
+
+            /*!
+             * \brief Show or hide this node (alongside its branch)
+             *
+             * Toggling the node's visibility changes the appearance of its
+             * parents, hence all of them are marked as having dirty
+             * descendants. The node's own dirty state, which may have piled
+             * up whilst it was hidden, is kept until it is shown and rendered.
+             *
+             * \param visible Whether the node should be visible.
+             *
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            Node& set_visible(bool visible) noexcept;
+
             /*!
              * \brief Check if node is very dirty
              *
@@ -312,8 +406,9 @@ namespace hmi_tree_optimization {
             /*!
              * \brief Restore dirtiness state after a frame render
              *
-             * Marks the node as not dirty. Should be called on every node after
-             * a frame rendering has finished.
+             * Marks the node as not dirty (and as having no dirty descendants).
+             * Should be called on every node after a frame rendering has
+             * finished.
              *
              * \return Reference to this instance.
              *
@@ -324,6 +419,17 @@ namespace hmi_tree_optimization {
             /*!
              * \brief Update this node
              *
+             * The update is not applied right away. Only the newest update
+             * parameters are kept pending until they are applied, hence
+             * several updates of the same node between two frames cost a
+             * single application.
+             *
+             * An update which would not change the node (e.g. a value which
+             * is resent unchanged) is ignored, i.e. the node is not marked as
+             * dirty.
+             *
+             * \see Node::apply_pending_update
+             *
              * \param parameters String parameters to be processed by a <!--
              * --> Node's subclass when updating.
              *
@@ -333,6 +439,106 @@ namespace hmi_tree_optimization {
              */
             Node& update(const std::vector<std::string>& parameters);
 
+            /*!
+             * \brief Update this node
+             *
+             * \details The parameters are swapped into the node's pending <!--
+             * --> buffer instead of being copied.
+             *
+             * \param parameters String parameters to be processed by a <!--
+             * --> Node's subclass when updating.
+             *
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            Node& update(std::vector<std::string>&& parameters);
+
+            /*!
+             * \brief Check whether an update would change the node's visible state
+             *
+             * \see Node::is_changed_by
+             *
+             * \param parameters String parameters of update.
+             *
+             * \return True if the update would change the node. False otherwise.
+             */
+            bool would_change(const std::vector<std::string>& parameters) const;
+
+            /*!
+             * \brief Check if node has a pending update
+             *
+             * \return True if an update has not been applied yet. False otherwise.
+             */
+            bool has_pending_update() const noexcept;
+
+            /*!
+             * \brief Apply the newest pending update (if there is one)
+             *
+             * Should be called before the node's state is used, i.e. when the
+             * frame is evaluated or right before the node is rendered. An
+             * update which would not change the node any more (i.e. it has
+             * been reverted since the node has been marked as dirty) is
+             * dropped and the node is marked as not dirty again.
+             *
+             * \see Node::update
+             *
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            Node& apply_pending_update();
+
+            /*!
+             * \brief Mark this node as dirty without updating it
+             *
+             * Used when the node's branch changes structurally (e.g. new
+             * children are attached to it), so that any cached state which
+             * includes it is refreshed. All of its (direct and indirect)
+             * parents are marked as having dirty descendants.
+             *
+             * \see Node::update
+             *
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            Node& mark_as_dirty() noexcept;
+
+            /*!
+             * \brief Invalidate any cached state of this node without marking it as dirty
+             *
+             * The node's revision is bumped, hence its subtree hash (and the
+             * hash of each of its ancestors) changes and no cache entry which
+             * has been built from its previous state matches it any more.
+             * Unlike Node::mark_as_dirty, neither the node nor its parents are
+             * marked as dirty.
+             *
+             * \see Node::subtree_hash
+             *
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            Node& bump_revision() noexcept;
+
+            /*!
+             * \brief Create a detached copy of this node
+             *
+             * The copy has the same type and content as this node, but it has
+             * no children and no parents. It is neither dirty nor very dirty.
+             *
+             * \details The copy is dynamically allocated. The caller is <!--
+             * --> responsible for freeing the allocated memory.
+             *
+             * \see Node::clone_node
+             *
+             * \param id The copy's assigned id.
+             *
+             * \return Pointer to copy of this node.
+             */
+            Node *clone(nid_t id) const;
+
             /*!
              * \brief Simulate time-consuming work when rendering a node
              *
@@ -376,6 +582,25 @@ namespace hmi_tree_optimization {
             Node& load_from_cache(const CacheEntry *entry, bool debug = false, 
                     std::ostream& out = std::cout);
 
+            /*!
+             * \brief Overwrite an existing cache entry with this node's current state
+             *
+             * Unlike Node::cache, no new cache entry is created. The given entry
+             * must have been previously generated by this node (or another node
+             * of the same type). Its storage is reused, i.e. re-caching a node
+             * does not allocate memory in a steady state.
+             *
+             * \param entry Cache entry which is overwritten.
+             * \param debug Indicates whether to display debug messages.
+             * \param out Output stream where debug messages are displayed.
+             *
+             * \return Reference to this instance.
+             *
+             * \remark The returned reference to this may be used for method chaining.
+             */
+            Node& recache(CacheEntry& entry, bool debug = false,
+                    std::ostream& out = std::cout);
+
             /*!
              * \brief Count the number of all direct and indirect children
              *
@@ -418,6 +643,40 @@ namespace hmi_tree_optimization {
              */
             virtual char to_letter() const noexcept = 0;
 
+            /*!
+             * \brief Hash the node's own content (excluding its children)
+             *
+             * Two nodes of the same type have identical content if and only if
+             * their content hashes are equal. Node ids, dirtiness and the
+             * node's neighbors do not affect the hash.
+             *
+             * \see Node::hash_content
+             *
+             * \return Hash of the node's content.
+             */
+            size_t content_hash() const noexcept;
+
+            /*!
+             * \brief Hash the node's whole branch (Merkle hash)
+             *
+             * The subtree hash combines the node's type and content hash with
+             * the subtree hashes of its visible children (regardless of their
+             * order). Any change within the branch (an applied update, a
+             * structural change, a child being shown or hidden, or the node
+             * being explicitly marked as dirty) changes the hash. Node ids do
+             * not affect it.
+             *
+             * \details The hash is maintained incrementally: a change only <!--
+             * --> marks the hashes of the changed node and its ancestors as <!--
+             * --> stale. They are recomputed on demand, each one from its <!--
+             * --> children's hashes.
+             *
+             * \see CacheEntry::get_source_hash
+             *
+             * \return Hash of the node's branch.
+             */
+            size_t subtree_hash() const noexcept;
+
         protected:
 
             /*!
@@ -429,6 +688,20 @@ namespace hmi_tree_optimization {
              */
             virtual void apply_update(const std::vector<std::string>& parameters) = 0;
 
+            /*!
+             * \brief Check whether update parameters differ from the node's state
+             *
+             * \details This method must be implemented by each Node subclass. <!--
+             * --> It must not report false unless applying the update would <!--
+             * --> leave the node unchanged.
+             *
+             * \param parameters String parameters of update.
+             *
+             * \return True if applying the update would change the node. <!--
+             * --> False otherwise.
+             */
+            virtual bool is_changed_by(const std::vector<std::string>& parameters) const = 0;
+
             /*!
              * \brief Generate an appropriate cache entry
              *
@@ -454,14 +727,75 @@ namespace hmi_tree_optimization {
              */
             virtual void use_cache_entry(const CacheEntry *entry) = 0;
 
+            /*!
+             * \brief Overwrite a cache entry with the node's current state
+             *
+             * The appropriate type of cache entry must be parsed to this
+             * method. The entry's attributes are assigned in place.
+             *
+             * \details This method must be implemented by each Node subclass.
+             *
+             * \param entry Cache entry which is overwritten.
+             */
+            virtual void update_cache_entry(CacheEntry& entry) = 0;
+
+            /*!
+             * \brief Hash the node's own content
+             *
+             * \details This method must be implemented by each Node subclass.
+             * \details Equal hashes must imply equal contents.
+             *
+             * \return Hash of the node's content.
+             */
+            virtual size_t hash_content() const noexcept = 0;
+
+            /*!
+             * \brief Create a detached copy of this node
+             *
+             * \details This method must be implemented by each Node subclass.
+             *
+             * \param id The copy's assigned id.
+             *
+             * \return Pointer to dynamically allocated copy of this node.
+             */
+            virtual Node *clone_node(nid_t id) const = 0;
+
         private:
 
+            /*!
+             * \brief Mark all (direct and indirect) parents as having dirty descendants
+             *
+             * \note The propagation stops at parents which have already been <!--
+             * --> marked, since their own parents must have been marked too. <!--
+             * --> It also stops at hidden nodes.
+             */
+            void propagate_dirtiness() const noexcept;
+
+            /*!
+             * \brief Mark the subtree hashes of this node and of all its ancestors as stale
+             *
+             * \note The propagation stops at already stale hashes, since their <!--
+             * --> ancestors' hashes must be stale too.
+             */
+            void invalidate_subtree_hash() const noexcept;
+
             static constexpr long render_time = 10;  /*!< Average (simulated) time for rendering. */
             nid_t id_;  /*!< The node's assigned id. */
             std::unordered_set<Node *> children_;  /*!< Set of all direct children. */
             std::unordered_set<const Node *> parents_;  /*!< Set of all direct parents. */
             bool dirty_;  /*!< Whether the node is dirty. */
+            mutable bool dirty_descendants_;  /*!< Whether any descendant node is dirty (set through const parent pointers). */
             bool very_dirty_;  /*!< Whether the node has been marked as very dirty. */
+            bool visible_;  /*!< Whether the node is visible. */
+            mutable bool shown_;  /*!< Whether the node has last been found to be shown. */
+            mutable size_t shown_epoch_;  /*!< Visibility epoch in which the node has last been checked. */
+            static size_t visibility_epoch_;  /*!< Number of changes to any node's visibility or parents. */
+            bool pending_update_;  /*!< Whether the pending update parameters are yet to be applied. */
+            bool dirty_by_update_;  /*!< Whether the node is dirty only because of its pending update. */
+            std::vector<std::string> pending_parameters_;  /*!< Newest update parameters. */
+            size_t revision_;  /*!< Number of times the node's cached state has been explicitly invalidated. */
+            mutable size_t subtree_hash_;  /*!< Last computed subtree hash. */
+            mutable bool subtree_hash_stale_;  /*!< Whether the subtree hash needs to be recomputed. */
         };  // class Node
 
         /*!
@@ -0,0 +1,113 @@
+/*!
+ * \file include/tree/string_table.hh
+ * \brief Definition of a table of interned strings
+ *
+ * HMI dashboards display a rather small vocabulary of strings (units, gear
+ * letters, status messages, etc.) over and over again. Instead of copying
+ * such strings around, each distinct string is stored exactly once in a
+ * string table and is then referenced by a small id.
+ *
+ * \see src/tree/string_table.cc
+ *
+ * \author Petar Nikolov
+ * \version v1.0.0
+ */
+
+#ifndef HMI_TREE_OPTIMIZATION__TREE__STRING_TABLE_HH
+#define HMI_TREE_OPTIMIZATION__TREE__STRING_TABLE_HH
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//! \namespace hmi_tree_optimization
+//! \brief Project namespace
+namespace hmi_tree_optimization {
+    //! \namespace tree
+    //! \brief Contains a bare bones simulated HMI tree
+    namespace tree {
+        using sid_t = unsigned int;  /*!< Alias type for an interned string's id. */
+
+        /*!
+         * \class StringTable
+         *
+         * \brief Stores each distinct string once and addresses it by id
+         *
+         * Interning a string which is already present in the table costs a
+         * single hash lookup and does not allocate any memory. Each interned
+         * string is reference counted: interning or retaining it acquires a
+         * reference and releasing it gives one back. Once the last reference
+         * is released, the string is removed and its id is reused by the next
+         * newly interned string, i.e. the table only ever holds the strings
+         * which are currently referenced.
+         */
+        class StringTable final {
+
+        public:
+
+            /*!
+             * \brief Construct string table
+             *
+             * \note The empty string is always interned with an id of '0' <!--
+             * --> and is never removed.
+             */
+            explicit StringTable();
+
+            StringTable(const StringTable&) = delete;
+            StringTable& operator=(const StringTable&) = delete;
+
+            /*!
+             * \brief Intern a string
+             *
+             * \param s String to intern.
+             *
+             * \return Id of interned string.
+             *
+             * \note A reference to the string is acquired, which has to be <!--
+             * --> given back by StringTable::release.
+             */
+            sid_t intern(const std::string& s);
+
+            /*!
+             * \brief Acquire another reference to an interned string
+             *
+             * \param id Id of interned string.
+             */
+            void retain(sid_t id) noexcept;
+
+            /*!
+             * \brief Give back a reference to an interned string
+             *
+             * \param id Id of interned string.
+             *
+             * \note The string is removed once its last reference is released.
+             */
+            void release(sid_t id);
+
+            /*!
+             * \brief Get an interned string
+             *
+             * \param id Id of interned string.
+             *
+             * \return Reference to interned string.
+             */
+            const std::string& lookup(sid_t id) const;
+
+            /*!
+             * \brief Get the number of interned strings
+             *
+             * \return Number of distinct strings in the table.
+             */
+            size_t size() const noexcept;
+
+        private:
+
+            std::unordered_map<std::string, sid_t> ids_;  /*!< Maps interned strings to their ids. */
+            std::vector<const std::string *> strings_;  /*!< Maps ids to interned strings (keys of ids_), nullptr for free ids. */
+            std::vector<size_t> refs_;  /*!< Maps ids to reference counts of interned strings. */
+            std::vector<sid_t> free_ids_;  /*!< Ids of removed strings which are reused first. */
+        };  // class StringTable
+    }  // namespace tree
+}  // namespace hmi_tree_optimization
+
+#endif  // HMI_TREE_OPTIMIZATION__TREE__STRING_TABLE_HH
@@ -0,0 +1,389 @@
+/*!
+ * \file src/benchmark/main.cc
+ * \brief Main program function of the benchmarks.
+ *
+ * The program runs synthetic workloads on the simulated HMI tree and reports
+ * measurements which are relevant to the optimization algorithm (memory usage,
+ * execution time, etc.). Each workload is called a scenario and is selected
+ * via the command line.
+ *
+ * \author Petar Nikolov
+ * \version v1.0.0
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "tree/hmi_tree.hh"
+#include "tree/node.hh"
+#include "tree/cache_entry.hh"
+#include "tree/hmi_objects/hmi_widget.hh"
+#include "tree/hmi_objects/hmi_text.hh"
+#include "heavy_hitters/cms.hh"
+#include "heavy_hitters/cms_shards.hh"
+
+using namespace hmi_tree_optimization;
+using namespace hmi_tree_optimization::tree;
+
+namespace {
+    int build(const std::vector<std::string>&);
+    int churn(const std::vector<std::string>&);
+    int ids(const std::vector<std::string>&);
+    int instantiate(const std::vector<std::string>&);
+    int sketch(const std::vector<std::string>&);
+    size_t resident_set_size() noexcept;
+}  // anonymous namespace
+
+/*!
+ * \brief Main program function
+ *
+ * The program must be run in the following way (assuming the user runs the
+ * program from the project's root directory):
+ *
+ * \code
+ * ./bin/benchmark {scenario} [arg1, arg2...]
+ * \endcode
+ *
+ * where:
+ *   - \a scenario: name of the benchmark scenario to run;
+ *   - [\a arg1, \a arg2...]: additional arguments (depend on the scenario).
+ *
+ * The available scenarios are the following:
+ * - \b build {nnodes}: builds a tree of \a nnodes nodes, listed in random
+ *   order, at once and prints how long it took;
+ * - \b churn {rounds} {report}: continuously replaces widgets and re-caches
+ *   nodes for \a rounds simulated frames and prints the state of the memory
+ *   pools and the resident set size every \a report frames.
+ * - \b ids {nids} {rounds}: leases \a nids node ids and then releases and
+ *   re-leases random ids for \a rounds times, and prints how long it took.
+ * - \b instantiate {ninstances}: spawns \a ninstances list rows both from
+ *   node records and from a prototype, and prints how long each way took.
+ * - \b sketch {nthreads} {nincrements}: lets \a nthreads producer threads
+ *   count \a nincrements node ids each, both in a single locked count-min
+ *   sketch and in per-thread shards which are merged afterwards, and prints
+ *   how long each way took.
+ *
+ * \warning If the user does not provide a known scenario the function <!--
+ * --> immediately terminates with exit status '-1'.
+ */
+int main(int argc, char *argv[]) {
+    srand(time(NULL));  // initialize random seed
+    if (argc < 2)
+        return -1;
+
+    std::string scenario = argv[1];
+    std::vector<std::string> args(argv + 2, argv + argc);
+
+    if (scenario.compare("build") == 0)
+        return build(args);
+    if (scenario.compare("churn") == 0)
+        return churn(args);
+    if (scenario.compare("ids") == 0)
+        return ids(args);
+    if (scenario.compare("instantiate") == 0)
+        return instantiate(args);
+    if (scenario.compare("sketch") == 0)
+        return sketch(args);
+    return -1;
+}
+
+namespace {
+    /*!
+     * \brief Bulk tree construction benchmark
+     *
+     * A layout of nested widgets, each holding several text nodes, is
+     * generated and shuffled, so that children usually precede their
+     * parents. The whole layout is then built into a tree at once.
+     *
+     * \see hmi_tree_optimization::tree::HMITree::build
+     */
+    int build(const std::vector<std::string>& args) {
+        constexpr size_t ntexts = 10;
+        size_t nnodes = args.size() > 0 ? std::stoul(args[0]) : 100000;
+        std::vector<NodeRecord> records;
+        std::vector<nid_t> widget_ids(1, 0);  // the root may hold widgets
+        HMITree tree;
+
+        records.reserve(nnodes);
+        while (records.size() < nnodes) {
+            nid_t widget_id = records.size() + 1;
+
+            records.push_back({widget_ids[rand() % widget_ids.size()], 'W', widget_id, {}});
+            widget_ids.push_back(widget_id);
+            for (size_t t = 0; t < ntexts && records.size() < nnodes; ++t)
+                records.push_back({widget_id, 'T', static_cast<nid_t>(records.size() + 1), {"text"}});
+        }
+        std::random_shuffle(records.begin(), records.end());
+
+        auto start = std::chrono::steady_clock::now();
+
+        tree.build(records);
+
+        auto end = std::chrono::steady_clock::now();
+
+        std::cout << "nodes,build_us" << std::endl;
+        std::cout << records.size() << ','
+            << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()
+            << std::endl;
+        return 0;
+    }
+
+    /*!
+     * \brief Allocation churn benchmark
+     *
+     * A tree of widgets, each holding several text nodes, is built. Then,
+     * for every simulated frame, one widget (alongside its children) is
+     * destroyed and replaced by a new one, whilst the cache entries of a
+     * few nodes are thrown away and regenerated - exactly like a re-cached
+     * node in the solution's cache table.
+     *
+     * The memory pools' counters and the process' resident set size are
+     * printed periodically. In a steady state neither of them should grow.
+     *
+     * \see hmi_tree_optimization::tree::MemoryPool
+     */
+    int churn(const std::vector<std::string>& args) {
+        constexpr size_t nwidgets = 100;
+        constexpr size_t ntexts = 10;
+        size_t nrounds = args.size() > 0 ? std::stoul(args[0]) : 100000;
+        size_t report = args.size() > 1 ? std::stoul(args[1]) : 10000;
+        HMITree tree;
+        std::vector<Node *> widgets(nwidgets, nullptr);
+        std::vector<CacheEntry *> entries(nwidgets, nullptr);
+        nid_t next_id = 1;
+        auto spawn_widget = [&tree, &next_id]() {
+            Node *widget = new HMIWidget(next_id++);
+
+            for (size_t t = 0; t < ntexts; ++t)
+                widget->add_child(new HMIText(next_id++, "text"));
+            tree.get_root().add_child(widget);
+            return widget;
+        };
+
+        for (size_t w = 0; w < nwidgets; ++w) {
+            widgets[w] = spawn_widget();
+            entries[w] = widgets[w]->cache();
+        }
+
+        std::cout << "round,node_chunks,node_live,entry_chunks,entry_live,rss_kb" << std::endl;
+        for (size_t round = 0; round <= nrounds; ++round) {
+            size_t w = rand() % nwidgets;
+
+            // replace a widget and its whole branch
+            tree.get_root().remove_child(widgets[w]);
+            delete widgets[w];
+            widgets[w] = spawn_widget();
+            // re-cache a few widgets
+            for (size_t r = 0; r < 4; ++r) {
+                w = rand() % nwidgets;
+                delete entries[w];
+                entries[w] = widgets[w]->cache();
+            }
+
+            if (round % report == 0)
+                std::cout << round << ','
+                    << Node::pool().nchunks() << ','
+                    << Node::pool().nlive_blocks() << ','
+                    << CacheEntry::pool().nchunks() << ','
+                    << CacheEntry::pool().nlive_blocks() << ','
+                    << resident_set_size() / 1024
+                    << std::endl;
+        }
+
+        for (CacheEntry *entry : entries)
+            delete entry;
+        return 0;
+    }
+
+    /*!
+     * \brief Node id allocation benchmark
+     *
+     * Simulates dynamic list items which come and go: the tree's id pool is
+     * filled with a number of leased ids, after which random ids are
+     * released and new ones are leased in their place. In a steady state
+     * the highest leased id should not grow.
+     *
+     * \see hmi_tree_optimization::tree::HMITree::lease_free_nid
+     * \see hmi_tree_optimization::tree::HMITree::release_nid
+     */
+    int ids(const std::vector<std::string>& args) {
+        size_t nids = args.size() > 0 ? std::stoul(args[0]) : 100000;
+        size_t nrounds = args.size() > 1 ? std::stoul(args[1]) : 1000000;
+        HMITree tree;
+        std::vector<nid_t> leased;
+        nid_t max_id = 0;
+
+        leased.reserve(nids);
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < nids; ++i)
+            leased.push_back(tree.lease_free_nid());
+
+        auto middle = std::chrono::steady_clock::now();
+
+        for (size_t round = 0; round < nrounds; ++round) {
+            nid_t& id = leased[rand() % nids];
+
+            tree.release_nid(id);
+            id = tree.lease_free_nid();
+            max_id = std::max(max_id, id);
+        }
+
+        auto end = std::chrono::steady_clock::now();
+
+        std::cout << "ids,rounds,lease_us,churn_us,max_id" << std::endl;
+        std::cout << nids << ','
+            << nrounds << ','
+            << std::chrono::duration_cast<std::chrono::microseconds>(middle - start).count() << ','
+            << std::chrono::duration_cast<std::chrono::microseconds>(end - middle).count() << ','
+            << max_id
+            << std::endl;
+        return 0;
+    }
+
+    /*!
+     * \brief Prototype instantiation benchmark
+     *
+     * A list row (a widget holding several text nodes) is spawned many times
+     * under a list widget in two separate trees: once by building node
+     * records (as if they had been parsed from the input) and once by
+     * instantiating a registered prototype of the row.
+     *
+     * \see hmi_tree_optimization::tree::HMITree::build
+     * \see hmi_tree_optimization::tree::HMITree::instantiate
+     */
+    int instantiate(const std::vector<std::string>& args) {
+        constexpr size_t ntexts = 10;
+        size_t ninstances = args.size() > 0 ? std::stoul(args[0]) : 1000;
+        HMITree built_tree;
+        HMITree prototype_tree;
+        std::vector<NodeRecord> records;
+
+        built_tree.build({{0, 'W', 1, {}}});
+        prototype_tree.build({{0, 'W', 1, {}}, {0, 'W', 2, {}}});
+        for (size_t t = 0; t < ntexts; ++t)
+            prototype_tree.build({{2, 'T', prototype_tree.lease_free_nid(), {"label"}}});
+        prototype_tree.register_prototype("row", 2);
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (nid_t next_id = 2; next_id < 2 + ninstances * (ntexts + 1);) {
+            nid_t row_id = next_id++;
+
+            records.clear();
+            records.push_back({1, 'W', row_id, {}});
+            for (size_t t = 0; t < ntexts; ++t)
+                records.push_back({row_id, 'T', next_id++, {"label"}});
+            built_tree.build(records);
+        }
+
+        auto middle = std::chrono::steady_clock::now();
+        Node& list = prototype_tree.get_node(1);
+
+        for (size_t i = 0; i < ninstances; ++i)
+            prototype_tree.instantiate("row", list);
+
+        auto end = std::chrono::steady_clock::now();
+
+        std::cout << "instances,build_us,instantiate_us" << std::endl;
+        std::cout << ninstances << ','
+            << std::chrono::duration_cast<std::chrono::microseconds>(middle - start).count() << ','
+            << std::chrono::duration_cast<std::chrono::microseconds>(end - middle).count()
+            << std::endl;
+        return 0;
+    }
+
+    /*!
+     * \brief Multi-threaded sketch ingestion benchmark
+     *
+     * Several producer threads count pseudo-random node ids. First, all of
+     * them increment a single count-min sketch which is guarded by a mutex.
+     * Then, each of them increments its own shard of another sketch, and
+     * the shards are merged at the end (as if at a frame boundary). Both
+     * sketches must end up with the same total count.
+     *
+     * \see hmi_tree_optimization::heavy_hitters::CMS
+     * \see hmi_tree_optimization::heavy_hitters::CMSShards
+     */
+    int sketch(const std::vector<std::string>& args) {
+        constexpr nid_t nids = 100000;
+        size_t nthreads = args.size() > 0 ? std::stoul(args[0]) : 4;
+        size_t nincrements = args.size() > 1 ? std::stoul(args[1]) : 1000000;
+        heavy_hitters::CMS<nid_t> locked_cms(10, 0.01);
+        heavy_hitters::CMS<nid_t> global_cms(10, 0.01);
+        heavy_hitters::CMSShards<nid_t> shards(global_cms, nthreads);
+        std::mutex cms_mutex;
+        std::vector<std::thread> producers;
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t t = 0; t < nthreads; ++t)
+            producers.emplace_back([&, t]() {
+                    nid_t id = static_cast<nid_t>(t);
+
+                    for (size_t i = 0; i < nincrements; ++i) {
+                        id = (id * 1103515245u + 12345u) % nids;
+                        std::lock_guard<std::mutex> lock(cms_mutex);
+                        locked_cms.increment(id);
+                    }
+                    });
+        for (auto& producer : producers)
+            producer.join();
+        producers.clear();
+
+        auto middle = std::chrono::steady_clock::now();
+
+        for (size_t t = 0; t < nthreads; ++t)
+            producers.emplace_back([&, t]() {
+                    heavy_hitters::CMS<nid_t>& shard = shards.shard(t);
+                    nid_t id = static_cast<nid_t>(t);
+
+                    for (size_t i = 0; i < nincrements; ++i) {
+                        id = (id * 1103515245u + 12345u) % nids;
+                        shard.increment(id);
+                    }
+                    });
+        for (auto& producer : producers)
+            producer.join();
+        shards.merge();
+
+        auto end = std::chrono::steady_clock::now();
+
+        std::cout << "threads,increments,locked_us,sharded_us,locked_m,sharded_m" << std::endl;
+        std::cout << nthreads << ','
+            << nincrements << ','
+            << std::chrono::duration_cast<std::chrono::microseconds>(middle - start).count() << ','
+            << std::chrono::duration_cast<std::chrono::microseconds>(end - middle).count() << ','
+            << locked_cms.mass() << ','
+            << global_cms.mass()
+            << std::endl;
+        return locked_cms.mass() == global_cms.mass() ? 0 : 1;
+    }
+
+    /*!
+     * \brief Get the resident set size of this process
+     *
+     * \note Only supported on Linux. Returns 0 otherwise.
+     *
+     * \return Resident set size in bytes.
+     */
+    size_t resident_set_size() noexcept {
+        std::ifstream statm("/proc/self/statm");
+        size_t npages_total = 0;
+        size_t npages_resident = 0;
+
+        if (!(statm >> npages_total >> npages_resident))
+            return 0;
+        return npages_resident * sysconf(_SC_PAGESIZE);
+    }
+}  // anonymous namespace
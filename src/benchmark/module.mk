@@ -0,0 +1,41 @@
+# Name of 'benchmark' module.
+BENCHMARK__MODULE_NAME := benchmark
+
+# Produced executable file name.
+BENCHMARK__EXECUTABLE := benchmark
+
+# Producer threads of the 'sketch' scenario require the POSIX threads library.
+LIBS += -pthread
+
+# C++ header files of 'benchmark' executable module.
+# Each implementation file ('.cc' file) in this module depends on the interface
+# which each header provides. Source files are recompiled if any one of these 
+# headers is altered.
+BENCHMARK__INCLUDE :=
+BENCHMARK__INCLUDE := $(patsubst %,$(INCLUDE)/$(BENCHMARK__MODULE_NAME)/%,$(BENCHMARK__INCLUDE))
+
+# C++ source files of 'benchmark' executable module.
+# NOTE: do not include source file with 'main' function definition (see below).
+BENCHMARK__SRC :=
+BENCHMARK__SRC := $(patsubst %,$(SRC)/$(BENCHMARK__MODULE_NAME)/%,$(BENCHMARK__SRC))
+# C++ source file with 'main' function definition.
+BENCHMARK__MAIN_SRC := main.cc
+BENCHMARK__MAIN_SRC := $(patsubst %,$(SRC)/$(BENCHMARK__MODULE_NAME)/%,$(BENCHMARK__MAIN_SRC))
+
+# Object files of 'benchmark' executable module.
+BENCHMARK__OBJ := $(patsubst $(SRC)/%.cc,$(OBJ)/%.o,$(BENCHMARK__SRC))
+BENCHMARK__MAIN_OBJ := $(patsubst $(SRC)/%.cc,$(OBJ)/%.o,$(BENCHMARK__MAIN_SRC))
+
+# Create required subdirectories for module's object files
+BENCHMARK__OBJ_DIRS := $(subst $(SRC),$(OBJ),$(shell find $(SRC)/$(BENCHMARK__MODULE_NAME)/ -type d))
+$(foreach obj_dir,$(BENCHMARK__OBJ_DIRS),$(shell mkdir -p $(obj_dir)))
+
+# Add executable module's target as dependency of the 'all' target.
+ALL_TARGETS += benchmark
+
+# Make target for 'benchmark' module's object files
+$(OBJ)/$(BENCHMARK__MODULE_NAME)/%.o: $(SRC)/$(BENCHMARK__MODULE_NAME)/%.cc $(BENCHMARK__INCLUDE)
+	@# Create temporary directory for object files.
+	@mkdir -p $(OBJ)/$(BENCHMARK__MODULE_NAME)
+	$(CXX) $(CXXFLAGS) -o $@ -c $< 
+
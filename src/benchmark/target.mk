@@ -0,0 +1,7 @@
+.PHONY: benchmark
+
+# Make target of 'benchmark' executable module.
+benchmark: $(BENCHMARK__MAIN_OBJ) $(BENCHMARK__OBJ) $(HELPER_OBJ) $(THIRD_PARTY_LIBS_OBJ)
+	$(CXX) $(CXXFLAGS) -o $(BIN)/$(BENCHMARK__EXECUTABLE) $(BENCHMARK__MAIN_OBJ) $(BENCHMARK__OBJ) $(HELPER_OBJ) $(THIRD_PARTY_LIBS_OBJ) $(LIBS)
+	@echo $(LOG_STAMP): $(BENCHMARK__MODULE_NAME) executable module compilation successful.
+
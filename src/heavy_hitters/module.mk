@@ -6,7 +6,10 @@ HEAVY_HITTERS__MODULE_NAME := heavy_hitters
 # which each header provides. Source files are recompiled if any one of these 
 # headers is altered.
 HEAVY_HITTERS__INCLUDE := \
-	cms.hh
+	cms.hh \
+	cms_shards.hh \
+	interval_estimator.hh \
+	recency_scorer.hh
 HEAVY_HITTERS__INCLUDE := $(patsubst %,$(INCLUDE)/$(HEAVY_HITTERS__MODULE_NAME)/%,$(HEAVY_HITTERS__INCLUDE))
 
 # C++ source files of 'heavy_hitters' module.
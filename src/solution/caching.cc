@@ -11,14 +11,24 @@
 #include "solution/caching.hh"
 
 #include <algorithm>
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <memory>
 #include <stack>
 #include <queue>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "solution/config.hh"
 #include "tree/hmi_tree.hh"
 #include "tree/node.hh"
 #include "tree/cache_entry.hh"
+#include "tree/hmi_exception.hh"
 
 using namespace hmi_tree_optimization::tree;
 
@@ -29,30 +39,781 @@ namespace hmi_tree_optimization {
     //! \brief Solution to the presented optimization problem
     namespace solution {
         namespace {
-            auto cmp = [](Node *child) {
-                return child->is_dirty();
+            /*!
+             * \struct SubtreeStats
+             *
+             * \brief Aggregates of a node's (shown) branch
+             *
+             * They are maintained bottom-up while evaluating the tree's
+             * dirtiness. Costs are measured in node renders.
+             */
+            struct SubtreeStats {
+                double rate;  /*!< Estimated probability of the node itself being updated in a frame. */
+                double change;  /*!< Estimated probability of any of the branch's nodes being updated in a frame. */
+                double cost;  /*!< Cost of rendering the whole branch. */
+                double best;  /*!< Expected cost per frame of refreshing the branch, given its caching decisions. */
+                bool split;  /*!< Whether the branch has last been left to its children to cache. */
+            };
+
+            /*!
+             * \struct PlacementItem
+             *
+             * \brief A shown node, as considered by the cache placement
+             */
+            struct PlacementItem {
+                Node *node = nullptr;  /*!< Considered node. */
+                double saving = 0.0;  /*!< Expected render cost saved per frame by caching the node's branch. */
+                double size = 0.0;  /*!< Size of the branch's cache entries (in bytes), measured or estimated. */
+                std::vector<size_t> children;  /*!< Positions of the node's children. */
+                size_t parent = 0;  /*!< Position of the node's parent (its own position for the root). */
+                double best = 0.0;  /*!< Highest priced saving within the node's branch. */
+                double best_size = 0.0;  /*!< Size of the cache entries which achieve it. */
+                bool cached = false;  /*!< Whether the highest priced saving caches the node's branch. */
             };
 
+            constexpr double rate_smoothing = 0.25;  /*!< Weight of the latest frame in the nodes' update rates. */
+            constexpr double price_precision = 1e-3;  /*!< Relative precision of the budget's price per byte. */
+
+            std::unordered_map<nid_t, SubtreeStats> g_subtree_stats;  /*!< Maps node ids to their branches' aggregates. */
+            std::unordered_set<nid_t> g_placement;  /*!< Ids of nodes whose branches are cached under the memory budget. */
+            double g_budget_price = 0.0;  /*!< Price of a byte of cache memory in the last placement (in node renders). */
+            std::vector<PlacementItem> g_placement_items;  /*!< Shown nodes as listed by the last placement. */
+            size_t g_placement_epoch = 0;  /*!< Visibility epoch in which the shown nodes have last been listed. */
+            size_t g_evaluations = 0;  /*!< Number of evaluations of the tree's dirtiness. */
+            std::unordered_map<nid_t, nid_t> g_identical_group_of;  /*!< Maps node ids to their group's (of identical subtrees) first id. */
+            std::unordered_map<nid_t, std::unordered_set<nid_t>> g_identical_groups;  /*!< Maps groups' first ids to their members' ids. */
+            std::unordered_map<nid_t, bool> g_versioned;  /*!< Maps ids of nodes whose previous versions are kept to whether they are heavy hitters themselves. */
+            std::unordered_map<nid_t, std::deque<std::shared_ptr<CacheEntry>>> g_cache_versions_of;  /*!< Maps node ids to their previous cache entries (most recent first). */
+            std::list<nid_t> g_recent_pages;  /*!< Ids of warm pages, most recently shown first. */
+            nid_t g_current_page = 0;  /*!< Id of currently shown page (0 if none has been switched to). */
+            std::unordered_map<nid_t, std::unordered_map<nid_t, size_t>> g_page_transitions;  /*!< Counts switches from one page to another. */
+
+            /*!
+             * \brief Remove a node from its group of identical subtrees.
+             *
+             * \see share_identical_subtrees()
+             */
+            void leave_identical_group(nid_t node_id) {
+                auto group_of_it = g_identical_group_of.find(node_id);
+
+                if (group_of_it == g_identical_group_of.end())
+                    return;
+
+                auto group_it = g_identical_groups.find(group_of_it->second);
+
+                group_it->second.erase(node_id);
+                if (group_it->second.empty())
+                    g_identical_groups.erase(group_it);
+                g_identical_group_of.erase(group_of_it);
+            }
+
+            /*!
+             * \brief Find a cache entry of a node's identical subtree.
+             *
+             * \return Cache entry to share, or null if there is none.
+             */
+            std::shared_ptr<CacheEntry> find_identical_entry(nid_t node_id) {
+                auto group_of_it = g_identical_group_of.find(node_id);
+
+                if (group_of_it == g_identical_group_of.end())
+                    return nullptr;
+                for (nid_t member_id : g_identical_groups.at(group_of_it->second)) {
+                    auto entry_it = g_cache_table.find(member_id);
+
+                    if (entry_it != g_cache_table.end())
+                        return entry_it->second;
+                }
+                return nullptr;
+            }
+
+            /*!
+             * \brief Make a node's version of a given branch its most recent one.
+             *
+             * \return True if such a version is kept. False otherwise.
+             */
+            bool _touch_version(std::deque<std::shared_ptr<CacheEntry>>& versions, size_t source_hash) {
+                auto version_it = std::find_if(versions.begin(), versions.end(),
+                        [source_hash](const std::shared_ptr<CacheEntry>& version) {
+                            return version->get_source_hash() == source_hash;
+                        });
+
+                if (version_it == versions.end())
+                    return false;
+                std::rotate(versions.begin(), version_it, std::next(version_it));
+                return true;
+            }
+
+            /*!
+             * \brief Keep a node's current state as one of its versions.
+             *
+             * Nothing is cached if a version of the node's branch is kept
+             * already. Once the node has all of its versions, the least
+             * recently used one is overwritten in place (unless an identical
+             * subtree shares it), i.e. no entry is allocated.
+             *
+             * \see stash_version()
+             */
+            void stash_current_version(Node& node) {
+                if (g_cache_versions < 2)
+                    return;
+
+                std::deque<std::shared_ptr<CacheEntry>>& versions = g_cache_versions_of[node.get_id()];
+
+                if (_touch_version(versions, node.subtree_hash()))
+                    return;
+                if (versions.size() < g_cache_versions - 1 || versions.back().use_count() > 1) {
+                    stash_version(node.get_id(), std::shared_ptr<CacheEntry>(node.cache(g_debug)));
+                    return;
+                }
+
+                std::shared_ptr<CacheEntry> entry = std::move(versions.back());
+
+                versions.pop_back();
+                node.recache(*entry, g_debug);
+                versions.push_front(std::move(entry));
+            }
+
+            /*!
+             * \brief Check whether any version of a node's cache entry matches its branch.
+             */
+            bool has_version(const Node& node) {
+                auto entry_it = g_cache_table.find(node.get_id());
+
+                if (entry_it != g_cache_table.end()
+                        && entry_it->second->get_source_hash() == node.subtree_hash())
+                    return true;
+
+                auto versions_it = g_cache_versions_of.find(node.get_id());
+
+                return versions_it != g_cache_versions_of.end()
+                    && std::any_of(versions_it->second.begin(), versions_it->second.end(),
+                            [&node](const std::shared_ptr<CacheEntry>& version) {
+                                return version->get_source_hash() == node.subtree_hash();
+                            });
+            }
+
+            /*!
+             * \brief Stop keeping the versions of a node's cache entry.
+             */
+            void drop_versions(nid_t node_id) {
+                if (g_versioned.erase(node_id))
+                    g_cache_versions_of.erase(node_id);
+            }
+
+            /*!
+             * \brief Mark the nodes of a branch which is cached as a whole as very clean.
+             */
+            void _clean_very_dirty_branch(Node& top) {
+                std::vector<Node *> pending(1, &top);
+
+                while (!pending.empty()) {
+                    Node *node = pending.back();
+
+                    pending.pop_back();
+                    node->mark_as_very_clean();
+                    for (Node *child : node->get_children())
+                        if (child->is_very_dirty())
+                            pending.push_back(child);
+                }
+            }
+
             /*!
              * \brief Evaluate the dirtiness of a given tree node.
              *
+             * \note The given node is evaluated even if it is hidden. Its <!--
+             * --> hidden children are not.
+             *
              * \see evaluate_tree_dirtiness()
              */
             void _evaluate_node_dirtiness(Node& node,
-                    const std::unordered_set<nid_t>& heavy_hitters) {
-                for (auto child_node : node.get_children())
-                    _evaluate_node_dirtiness(*child_node, heavy_hitters);
+                    const DirtinessScore& score, double threshold,
+                    std::unordered_set<const Node *>& evaluated) {
+                if (!evaluated.insert(&node).second)
+                    return;  // shared branch has already been evaluated
+                bool versioned_child = false;
+                double unchanged_children = 1.0;
+                double children_cost = 0.0;
+                double children_best = 0.0;
+
+                node.apply_pending_update();  // only the newest update is applied
+                for (auto child_node : node.get_children()) {
+                    if (child_node->is_visible()) {  // hidden branches are not evaluated
+                        _evaluate_node_dirtiness(*child_node, score, threshold, evaluated);
+                        versioned_child = versioned_child
+                            || g_versioned.find(child_node->get_id()) != g_versioned.end();
+
+                        const SubtreeStats& child_stats = g_subtree_stats[child_node->get_id()];
+
+                        unchanged_children *= 1 - child_stats.change;
+                        children_cost += child_stats.cost;
+                        children_best += child_stats.best;
+                    }
+                }
+
+                SubtreeStats& stats = g_subtree_stats[node.get_id()];
+
+                stats.rate += rate_smoothing * ((node.is_dirty() ? 1.0 : 0.0) - stats.rate);
+                stats.change = 1 - (1 - stats.rate) * unchanged_children;
+                stats.cost = 1 + children_cost;
 
-                if (heavy_hitters.find(node.get_id()) != heavy_hitters.end())
+                // expected cost per frame if the node is not cached (its
+                // children decide on their own), or if its branch is cached
+                // as a whole (it is re-rendered and re-cached whenever any of
+                // its nodes changes, and loaded from the cache otherwise);
+                // switching between the two requires rendering the branch
+                // (or its children) once, hence the previous decision is
+                // kept unless switching pays off within a single frame
+                double uncached = 1 + children_best;
+                double cached = stats.change * (stats.cost + g_cache_store_cost)
+                    + (1 - stats.change) * g_cache_load_cost;
+
+                if (node.is_dirty() || node.has_dirty_descendants())
+                    // node is no longer identical to its group's other subtrees
+                    leave_identical_group(node.get_id());
+
+                bool hitter = score(node.get_id()) >= threshold;
+
+                // the versions of heavy hitters and of their ancestors are kept
+                if (g_cache_versions > 1 && (hitter || versioned_child))
+                    g_versioned[node.get_id()] = hitter;
+                else
+                    drop_versions(node.get_id());
+
+                if (node.to_letter() == 'V') {
+                    // views are never cached
+                    stats.best = uncached;
+                } else if (hitter && !(g_cache_versions > 1 && has_version(node))) {
                     // node is a heavy hitter - mark as not fit for caching
+                    // (unless one of its versions matches, i.e. it changes
+                    // among few states)
                     node.mark_as_very_dirty();
-                else
-                    node.mark_as_very_clean();
-                node.clean_up();
+                    stats.best = uncached;
+                } else if (stats.split ? cached + stats.cost < uncached : cached <= uncached + children_cost) {
+                    // caching the whole branch pays off, even if some of its
+                    // nodes are heavy hitters
+                    if (node.is_very_dirty())
+                        _clean_very_dirty_branch(node);
+                    stats.best = cached;
+                    stats.split = false;
+                } else {
+                    // branch changes too often - its nodes are better off
+                    // being cached individually
+                    node.mark_as_very_dirty();
+                    stats.best = uncached;
+                    stats.split = true;
+                }
+            }
+
+            /*!
+             * \brief Choose the branches with the highest priced savings.
+             *
+             * Each branch may either be cached as a whole or left to its
+             * children, which is solved bottom-up in a single pass.
+             *
+             * \param items Shown nodes, children before their parents.
+             * \param price Price of a byte of cache memory.
+             *
+             * \return Size of the chosen branches' cache entries.
+             */
+            double _price_placement(std::vector<PlacementItem>& items, double price) {
+                for (auto& item : items) {
+                    double children_best = 0.0;
+                    double children_size = 0.0;
+
+                    for (size_t child : item.children) {
+                        children_best += items[child].best;
+                        children_size += items[child].best_size;
+                    }
+                    item.cached = item.node->to_letter() != 'V'
+                        && item.saving - price * item.size > children_best;
+                    item.best = item.cached ? item.saving - price * item.size : children_best;
+                    item.best_size = item.cached ? item.size : children_size;
+                }
+                return items.empty() ? 0.0 : items.back().best_size;
+            }
+
+            /*!
+             * \brief List the shown nodes of a tree, children before their parents.
+             *
+             * The tree is walked depth-first with an explicit stack, i.e. a
+             * deep tree cannot overflow the call stack.
+             *
+             * \note A branch which is referenced by several parents is <!--
+             * --> listed only once, as a child of the first one.
+             */
+            void _list_placement_items(Node& root, std::vector<PlacementItem>& items) {
+                struct Frame {
+                    Node *node;  // listed node
+                    std::unordered_set<Node *>::const_iterator next;  // next child to visit
+                    std::vector<size_t> children;  // positions of listed children
+                };
+
+                std::unordered_set<const Node *> listed;
+                std::vector<Frame> pending;
+
+                items.clear();
+                listed.insert(&root);
+                pending.push_back(Frame{&root, root.get_children().begin(), {}});
+                while (!pending.empty()) {
+                    Frame& frame = pending.back();
+
+                    if (frame.next != frame.node->get_children().end()) {
+                        Node *child = *frame.next++;
+
+                        if (child->is_visible() && listed.insert(child).second)
+                            pending.push_back(Frame{child, child->get_children().begin(), {}});
+                        continue;
+                    }
+
+                    PlacementItem item;
+
+                    item.node = frame.node;
+                    item.children = std::move(frame.children);
+                    item.parent = items.size();
+                    for (size_t child : item.children)
+                        items[child].parent = items.size();
+                    items.push_back(std::move(item));
+                    pending.pop_back();
+                    if (!pending.empty())
+                        pending.back().children.push_back(items.size() - 1);
+                }
+            }
+
+            /*!
+             * \brief Measure the memory taken up by a node's cache entries.
+             *
+             * \return Size of the node's entry and its versions (in bytes), <!--
+             * --> or 0 if the node has not been cached.
+             */
+            double _measure_entries(nid_t node_id) {
+                double size = 0.0;
+                auto entry_it = g_cache_table.find(node_id);
+                auto versions_it = g_cache_versions_of.find(node_id);
+
+                if (entry_it != g_cache_table.end())
+                    size += entry_it->second->size();
+                if (versions_it != g_cache_versions_of.end())
+                    for (const auto& version : versions_it->second)
+                        size += version->size();
+                return size;
+            }
+
+            /*!
+             * \brief Update the savings and sizes of the placement's items.
+             *
+             * The sizes of cached branches are measured. Branches which have
+             * not been cached are assumed to take up as much as the measured
+             * ones do on average (or g_node_entry_size if none is cached).
+             */
+            void _update_placement_items(std::vector<PlacementItem>& items) {
+                double measured_size = 0.0;
+                size_t nmeasured = 0;
+
+                for (auto& item : items) {
+                    auto stats_it = g_subtree_stats.find(item.node->get_id());
+                    double cost = stats_it == g_subtree_stats.end() ? 1.0 : stats_it->second.cost;
+                    double change = stats_it == g_subtree_stats.end() ? 1.0 : stats_it->second.change;
+
+                    item.saving = cost - change * (cost + g_cache_store_cost)
+                        - (1 - change) * g_cache_load_cost;
+                    item.size = _measure_entries(item.node->get_id());
+                    if (item.size > 0) {
+                        measured_size += item.size;
+                        ++nmeasured;
+                    }
+                }
+
+                double estimated_size = nmeasured ? measured_size / nmeasured : g_node_entry_size;
+
+                for (auto& item : items)
+                    if (item.size <= 0)
+                        item.size = estimated_size;
+            }
+
+            /*!
+             * \brief Choose the branches to cache under the memory budget.
+             *
+             * This is the tree knapsack problem: a set of disjoint branches
+             * is chosen which maximizes the expected render cost saved per
+             * frame, whilst their cache entries fit the budget. Instead of
+             * the exact (pseudo-polynomial) dynamic programming, the budget
+             * is relaxed into a price per byte, which takes a single linear
+             * pass per price. Finally, the budget left over (e.g. because
+             * many branches have equal savings) is filled greedily by the
+             * remaining branches with the highest saving per byte.
+             *
+             * The placement is incremental: the shown nodes are only listed
+             * anew once the tree's structure or visibility has changed, and
+             * the lowest price at which the chosen entries fit is searched
+             * for around the last placement's price, since the rates drift
+             * slowly between placements.
+             *
+             * \note Before the greedy filling the result is optimal for <!--
+             * --> the budget which it takes up.
+             */
+            void _place_branches(Node& root) {
+                std::vector<PlacementItem>& items = g_placement_items;
+                double budget = static_cast<double>(g_cache_budget);
+                double low = 0.0;
+                double high = g_budget_price;
+
+                if (items.empty() || items.back().node != &root
+                        || g_placement_epoch != Node::get_visibility_epoch()) {
+                    _list_placement_items(root, items);
+                    g_placement_epoch = Node::get_visibility_epoch();
+                }
+                _update_placement_items(items);
+                if (_price_placement(items, 0.0) > budget) {
+                    // bracket the lowest sufficient price ...
+                    if (high <= 0.0 || _price_placement(items, high) > budget) {
+                        low = high;
+                        high = std::max(2 * high, 1.0 / g_node_entry_size);
+                        while (_price_placement(items, high) > budget) {
+                            low = high;
+                            high *= 2;
+                        }
+                    } else {
+                        low = high / 2;
+                        while (_price_placement(items, low) <= budget) {
+                            high = low;
+                            low /= 2;
+                        }
+                    }
+                    // ... and bisect it
+                    for (int i = 0; i < 32 && high - low > price_precision * high; ++i) {
+                        double price = (low + high) / 2;
+
+                        if (_price_placement(items, price) > budget)
+                            low = price;
+                        else
+                            high = price;
+                    }
+                } else {
+                    high = 0.0;
+                }
+                _price_placement(items, high);
+                g_budget_price = high;
+
+                // collect the chosen branches top-down
+                std::vector<size_t> pending(1, items.size() - 1);
+                std::vector<bool> occupied(items.size(), false);  // branch contains a chosen one
+                double size = 0.0;
+
+                g_placement.clear();
+                while (!pending.empty()) {
+                    size_t position = pending.back();
+                    const PlacementItem& item = items[position];
+
+                    pending.pop_back();
+                    if (item.cached) {
+                        g_placement.insert(item.node->get_id());
+                        size += item.size;
+                        for (size_t i = position; !occupied[i]; i = items[i].parent)
+                            occupied[i] = true;
+                    } else {
+                        pending.insert(pending.end(), item.children.begin(), item.children.end());
+                    }
+                }
+
+                // fill the leftover budget greedily
+                std::vector<size_t> candidates;
+
+                for (size_t i = 0; i < items.size(); ++i)
+                    if (!occupied[i] && items[i].saving > 0 && items[i].node->to_letter() != 'V')
+                        candidates.push_back(i);
+                std::sort(candidates.begin(), candidates.end(), [&items](size_t left, size_t right) {
+                        return items[left].saving / items[left].size > items[right].saving / items[right].size;
+                        });
+                for (size_t candidate : candidates) {
+                    const PlacementItem& item = items[candidate];
+                    bool covered = false;
+
+                    if (occupied[candidate] || size + item.size > budget)
+                        continue;
+                    for (size_t i = candidate; !covered && items[i].parent != i; i = items[i].parent)
+                        covered = g_placement.find(items[items[i].parent].node->get_id()) != g_placement.end();
+                    if (covered)
+                        continue;
+                    g_placement.insert(item.node->get_id());
+                    size += item.size;
+                    for (size_t i = candidate; !occupied[i]; i = items[i].parent)
+                        occupied[i] = true;
+                }
+                if (g_debug)
+                    std::cout << "Placing " << g_placement.size() << " cached branches in "
+                        << size << " bytes" << std::endl;
+            }
+
+            /*!
+             * \brief Mark the shown nodes according to the placement of cached branches.
+             *
+             * The placed branches are very clean, all other nodes are very
+             * dirty.
+             */
+            void _apply_placement(Node& root) {
+                std::unordered_set<const Node *> visited;
+                std::vector<Node *> pending(1, &root);
+
+                visited.insert(&root);
+                while (!pending.empty()) {
+                    Node *node = pending.back();
+
+                    pending.pop_back();
+                    if (g_placement.find(node->get_id()) != g_placement.end()) {
+                        node->mark_as_very_clean();
+                        if (node->is_very_dirty())
+                            _clean_very_dirty_branch(*node);
+                        continue;
+                    }
+                    node->mark_as_very_dirty();
+                    for (Node *child : node->get_children())
+                        if (child->is_visible() && visited.insert(child).second)
+                            pending.push_back(child);
+                }
+            }
+
+            /*!
+             * \brief Refresh a very clean node, i.e. restore or cache its branch.
+             *
+             * \param node Very clean node.
+             * \param cached_ids Ids of nodes which have been cached or loaded.
+             *
+             * \see _refresh_branch()
+             */
+            void _refresh_very_clean_node(Node& node, std::unordered_set<nid_t>& cached_ids) {
+                nid_t node_id = node.get_id();
+                bool versioned = g_versioned.find(node_id) != g_versioned.end();
+                auto entry_it = g_cache_table.find(node_id);
+                std::shared_ptr<CacheEntry> version;
+
+                if (versioned && (entry_it == g_cache_table.end()
+                            || entry_it->second->get_source_hash() != node.subtree_hash())
+                        && (version = take_version(node_id, node.subtree_hash()))) {
+                    // a previous version of the node's branch is restored
+                    if (entry_it == g_cache_table.end()) {
+                        g_cache_table.insert(std::make_pair(node_id, version));
+                    } else {
+                        stash_version(node_id, std::move(entry_it->second));
+                        entry_it->second = version;
+                    }
+                    node.load_from_cache(version.get(), g_debug);
+                } else if (entry_it == g_cache_table.end()) {
+                    // node has not been cached so far
+                    std::shared_ptr<CacheEntry> identical_entry = find_identical_entry(node_id);
+
+                    if (identical_entry && identical_entry->get_source_hash() == node.subtree_hash()) {
+                        // an identical subtree's entry is shared
+                        node.load_from_cache(identical_entry.get(), g_debug);
+                        g_cache_table.insert(std::make_pair(node_id, identical_entry));
+                    } else {
+                        node.render(g_debug);
+                        g_cache_table.insert(std::make_pair(node_id,
+                                    std::shared_ptr<CacheEntry>(node.cache(g_debug))));
+                    }
+                } else if (entry_it->second->get_source_hash() != node.subtree_hash()) {
+                    // node has been cached, but its branch has changed since:
+                    // its existing cache entry is overwritten in place
+                    // if no identical subtree shares it (copy-on-write)
+                    // and if it is not kept as a previous version
+                    std::shared_ptr<CacheEntry>& entry = entry_it->second;
+
+                    node.render(g_debug);
+                    if (versioned) {
+                        stash_version(node_id, std::move(entry));
+                        entry.reset(node.cache(g_debug));
+                    } else if (entry.use_count() > 1) {
+                        entry.reset(node.cache(g_debug));
+                    } else {
+                        node.recache(*entry, g_debug);
+                    }
+                } else {
+                    // an appropriate cache entry is loaded from the cache
+                    // table, and the node's state is restored
+                    node.load_from_cache(entry_it->second.get(), g_debug);
+                }
+                cached_ids.insert(node_id);
+            }
+
+            /*!
+             * \brief Check whether a shared node is covered by a cached ancestor.
+             *
+             * A shared branch which is part of a very clean (i.e. cached)
+             * shown branch is owned by the latter's cache entry, even if the
+             * branch is also referenced by a very dirty node.
+             *
+             * \see _refresh_branch()
+             */
+            bool _is_covered(const Node& node) {
+                std::unordered_set<const Node *> reached;
+                std::vector<const Node *> pending;
+
+                for (const Node *parent : node.get_parents())
+                    if (parent->is_visible() && reached.insert(parent).second)
+                        pending.push_back(parent);
+                while (!pending.empty()) {
+                    const Node *ancestor = pending.back();
+
+                    pending.pop_back();
+                    if (ancestor->is_very_clean())
+                        return true;
+                    for (const Node *parent : ancestor->get_parents())
+                        if (parent->is_visible() && reached.insert(parent).second)
+                            pending.push_back(parent);
+                }
+                return false;
+            }
+
+            /*!
+             * \brief Refresh a branch of the tree.
+             *
+             * \note The given top node is refreshed even if it is hidden. Its <!--
+             * --> hidden children are not, they are collected instead.
+             *
+             * \param top Top node of branch.
+             * \param cached_ids Ids of nodes which have been cached or loaded.
+             * \param visited Nodes which have been reached.
+             * \param hidden Hidden nodes which have been reached.
+             *
+             * \see refresh_screen()
+             */
+            void _refresh_branch(Node& top, std::unordered_set<nid_t>& cached_ids,
+                    std::unordered_set<const Node *>& visited, std::vector<Node *>& hidden) {
+                Node *node;
+                std::queue<Node *> nodes;
+                nid_t node_id;
+                std::unordered_map<nid_t, bool>::const_iterator versioned_it;
+                bool versioned;
+
+                nodes.push(&top);
+                while (!nodes.empty()) {
+                    node = nodes.front();
+                    nodes.pop();
+                    if (!visited.insert(node).second)
+                        continue;  // shared branch has already been refreshed
+                    if (node != &top && !node->is_visible()) {
+                        hidden.push_back(node);
+                        continue;
+                    }
+                    if (node != &top && node->get_parents().size() > 1 && _is_covered(*node))
+                        continue;  // shared branch is owned by a cached ancestor's entry
+                    node_id = node->get_id();
+                    versioned_it = g_versioned.find(node_id);
+                    versioned = versioned_it != g_versioned.end();
+                    if (node->is_very_clean()) {
+                        _refresh_very_clean_node(*node, cached_ids);
+                    } else {  // if (node->is_very_dirty())
+                        auto cache_entry_it = g_cache_table.find(node_id);
+
+                        if (cache_entry_it != g_cache_table.end()) {
+                            // delete unnecessary cache entry (unless it is kept
+                            // as a previous version)
+                            if (versioned)
+                                stash_version(node_id, std::move(cache_entry_it->second));
+                            g_cache_table.erase(cache_entry_it);
+                        }
+                        node->render(g_debug);
+                        if (versioned && versioned_it->second)
+                            // a heavy hitter's rendered state is kept as a version
+                            stash_current_version(*node);
+
+                        // add a very dirty node's children for processing
+                        for (auto child_node : node->get_children())
+                            nodes.push(child_node);
+                    }
+                }
+            }
+
+            /*!
+             * \brief Reset the dirtiness state of each shown node of a branch.
+             *
+             * \note The given top node is cleaned up even if it is hidden. <!--
+             * --> Its hidden children are not.
+             *
+             * \see refresh_screen()
+             */
+            void _clean_up_branch(Node& top) {
+                std::unordered_set<const Node *> visited;
+                std::vector<Node *> pending(1, &top);
+
+                visited.insert(&top);
+                while (!pending.empty()) {
+                    Node *node = pending.back();
+
+                    pending.pop_back();
+                    node->clean_up();
+                    for (Node *child : node->get_children())
+                        if (child->is_visible() && visited.insert(child).second)
+                            pending.push_back(child);
+                }
+            }
+
+            /*!
+             * \brief Find a page, i.e. a direct child of the tree's root.
+             *
+             * \return The page's node, or null if there is none.
+             */
+            Node *find_page(HMITree& tree, nid_t page_id) {
+                for (Node *page : tree.get_root().get_children())
+                    if (page->get_id() == page_id)
+                        return page;
+                return nullptr;
+            }
+
+            /*!
+             * \brief Drop the cache entries of a whole branch.
+             *
+             * Besides the entries themselves, the branch's previous versions
+             * and placement are dropped as well.
+             *
+             * \return Number of dropped cache entries.
+             */
+            size_t drop_branch_entries(const Node& top) {
+                size_t ndropped = 0;
+                std::unordered_set<const Node *> visited;
+                std::vector<const Node *> pending(1, &top);
+
+                while (!pending.empty()) {
+                    const Node *node = pending.back();
+
+                    pending.pop_back();
+                    ndropped += g_cache_table.erase(node->get_id());
+                    g_placement.erase(node->get_id());
+                    leave_identical_group(node->get_id());
+                    drop_versions(node->get_id());
+                    for (const Node *child : node->get_children())
+                        if (child->get_parents().size() < 2 || visited.insert(child).second)
+                            pending.push_back(child);
+                }
+                return ndropped;
+            }
+
+            /*!
+             * \brief Move a page to a position of the list of warm pages.
+             *
+             * The least recently shown pages beyond the page cache's capacity
+             * are evicted, i.e. their cache entries are dropped (unless they
+             * are shown).
+             *
+             * \param rank Position of page in list (0 for the most recent).
+             */
+            void touch_page(HMITree& tree, nid_t page_id, size_t rank) {
+                g_recent_pages.remove(page_id);
+                g_recent_pages.insert(std::next(g_recent_pages.begin(),
+                            std::min(rank, g_recent_pages.size())), page_id);
+                while (g_recent_pages.size() > g_page_cache_capacity) {
+                    Node *evicted = find_page(tree, g_recent_pages.back());
+
+                    g_recent_pages.pop_back();
+                    if (evicted && !evicted->is_visible()) {
+                        if (g_debug)
+                            std::cout << "Evicting page " << evicted->get_id() << std::endl;
+                        drop_branch_entries(*evicted);
+                    }
+                }
             }
         }  // anonymous namespace
 
-        std::unordered_map<nid_t, CacheEntry *> g_cache_table;
+        std::unordered_map<nid_t, std::shared_ptr<CacheEntry>> g_cache_table;
 
         /*!
          * \brief Evaluate the dirtiness of each tree node.
@@ -64,16 +825,57 @@ namespace hmi_tree_optimization {
          * marked as either very dirty or very clean before evaluating the
          * parent.
          *
-         * Essentially a node is marked as very dirty only if it is considered
-         * a heavy hitter (i.e. a frequently updated element). All other nodes
-         * are marked as very clean.
+         * A node which is considered a heavy hitter (i.e. its dirtiness score
+         * reaches the threshold) is marked as very dirty. For all other nodes
+         * the decision is tree-aware: the aggregates of each node's branch
+         * (the probability of any of its nodes being updated in a frame, and
+         * the cost of rendering it) are maintained bottom-up. A node is
+         * marked as very clean if caching its whole branch is expected to
+         * cost less render time per frame than rendering the node itself
+         * and leaving the decision to its children. This way an expensive
+         * branch with a rarely updated heavy hitter may still be cached as a
+         * whole, whereas a branch whose many nodes are each updated now and
+         * then is not.
+         *
+         * The newest pending update of each evaluated node is applied, i.e.
+         * the updates which have been superseded within the same frame are
+         * never applied.
+         *
+         * A branch which is referenced by several parents is evaluated only
+         * once. Hidden branches are not evaluated at all. Updated branches
+         * leave their groups of identical subtrees.
+         */
+        void evaluate_tree_dirtiness(HMITree& tree,
+                const DirtinessScore& score, double threshold) {
+            std::unordered_set<const Node *> evaluated;
+
+            _evaluate_node_dirtiness(tree.get_root(), score, threshold, evaluated);
+            if (g_cache_budget > 0) {
+                if (g_evaluations % std::max<size_t>(g_placement_period, 1) == 0)
+                    _place_branches(tree.get_root());
+                _apply_placement(tree.get_root());
+            }
+            ++g_evaluations;
+        }
+
+        /*!
+         * \brief Get the render cost of a node's shown branch.
+         */
+        double branch_cost(nid_t node_id) {
+            auto stats_it = g_subtree_stats.find(node_id);
+
+            return stats_it == g_subtree_stats.end() ? 1.0 : stats_it->second.cost;
+        }
+
+        /*!
+         * \brief Get the weight of a node's occurrence in the frequency counts.
          *
-         * All nodes are cleaned up (have their dirty state reset) for the
-         * duration of the next frame in this step.
+         * \details The branch's cost is rounded, but never below 1.
          */
-        void evaluate_tree_dirtiness(HMITree& tree, 
-                const std::unordered_set<nid_t>& heavy_hitters) {
-            _evaluate_node_dirtiness(tree.get_root(), heavy_hitters);
+        size_t occurrence_weight(nid_t node_id) {
+            if (!g_weighted_counts)
+                return 1;
+            return std::max<long>(std::lround(branch_cost(node_id)), 1);
         }
 
         /*!
@@ -84,83 +886,276 @@ namespace hmi_tree_optimization {
          * children nodes. This way the optimization algorithm will always
          * prefer the highest possible nodes in the tree's hierarchy to cache.
          *
-         * If a node is marked as very clean, one of two scenarios occur:
-         * - should the node be updated, it is firstly rendered again, cached
-         *   into an appropriate cache entry and the cache table is updated 
-         *   accordingly;
-         * - if the node is not dirty, it is directly loaded from the cache
-         *   table.
-         * In both cases all of the node's children (direct and indirect) are
+         * If a node is marked as very clean, one of three scenarios occurs:
+         * - should the node's branch have changed, it is firstly rendered again and
+         *   cached: either into a new cache entry which is stored in the cache
+         *   table, or by overwriting the node's existing cache entry in place
+         *   (unless the entry is shared with an identical subtree);
+         * - if the node has not been cached so far, but an identical subtree
+         *   has been, their cache entry is shared and loaded;
+         * - if the node's branch is unchanged, it is directly loaded from the
+         *   cache table.
+         * In all cases all of the node's children (direct and indirect) are
          * popped from the stack data structure as they do not need to be
          * examined further.
          * Otherwise, if a node is marked as very dirty, its cache entry is
          * deleted (if there is one) and it is rendered.
          *
+         * A node's branch is considered changed if its subtree hash differs
+         * from the hash which its cache entry has been built from. Hence, a
+         * value which has changed back and forth between two frames does not
+         * force a re-render, whilst any deeper change does. A branch which is
+         * referenced by several parents is processed only once per frame,
+         * i.e. it is rendered once and owns a single cache table entry. If
+         * it is part of a cached branch, it is owned by that branch's entry
+         * instead, even if it is also referenced by a very dirty node.
+         * Hidden branches are skipped altogether.
+         *
          * After the traversal process is complete, this routine cleans the
          * cache table of unnecessary cache table entries (i.e. whose 
-         * corresponding nodes have a higher parent cached).
+         * corresponding nodes have a higher parent cached). If the page
+         * cache is enabled, the entries of hidden branches are kept, so that
+         * they can be loaded as soon as the branches are shown again.
+         * Otherwise, they are dropped like any other unused entry.
+         *
+         * Finally, all shown nodes are cleaned up (have their dirty state
+         * reset) for the duration of the next frame. Hidden nodes keep their
+         * dirty state until they are shown and rendered.
          */
         void refresh_screen(HMITree& tree) {
-            Node *node;
-            std::queue<Node *> nodes;
-            nid_t node_id;
             std::unordered_set<nid_t> cached_ids;
             std::unordered_set<nid_t> erased_entries;
+            std::unordered_set<const Node *> visited;
+            std::vector<Node *> hidden;
 
-            // start from the root node
-            nodes.push(&tree.get_root());
-            while (!nodes.empty()) {
-                node = nodes.front();
-                nodes.pop();
-                node_id = node->get_id();
-                if (node->is_very_clean()) {
-                    const std::unordered_set<Node *>& node_children = node->get_children();
-
-                    if (g_cache_table.find(node_id) == g_cache_table.end()) {
-                        // node has not been cached so far
-                        node->render(g_debug);
-                        g_cache_table.insert(std::make_pair(node_id, node->cache(g_debug)));
-                    } else if (std::any_of(node_children.begin(), node_children.end(), cmp)) {
-                        // node has been cached, but needs to be updated
-                        node->render(g_debug);
-                        delete g_cache_table.at(node_id);
-                        g_cache_table.insert(std::make_pair(node_id, node->cache(g_debug)));
-                    } else {
-                        // an appropriate cache entry is loaded from the cache
-                        // table, and the node's state is restored
-                        node->load_from_cache(g_cache_table.at(node_id), g_debug);
-                    }
-                    cached_ids.insert(node_id);
-                } else {  // if (node->is_very_dirty())
-                    auto cache_entry_it = g_cache_table.find(node_id);
-
-                    if (cache_entry_it != g_cache_table.end()) {
-                        // delete unnecessary cache entry
-                        delete g_cache_table.at(node_id);
-                        g_cache_table.erase(cache_entry_it);
-                    }
-                    node->render(g_debug);
-
-                    // add a very dirty node's children for processing
-                    for (auto child_node : node->get_children())
-                        nodes.push(child_node);
-                }
-            }
+            _refresh_branch(tree.get_root(), cached_ids, visited, hidden);
 
             // garbage collection:
             // erase unnecessary cache table entries
             for (auto& entry : g_cache_table) {
                 auto cache_entry_it = cached_ids.find(entry.first);
 
-                if (cache_entry_it == cached_ids.end()) {
-                    delete entry.second;
+                if (cache_entry_it == cached_ids.end())
                     erased_entries.insert(entry.first);
+            }
+            if (!erased_entries.empty() && !hidden.empty() && g_page_cache_capacity > 0) {
+                // keep the entries of hidden branches (the page cache evicts
+                // them once their pages have not been shown for long)
+                std::vector<const Node *> pending(hidden.begin(), hidden.end());
+
+                while (!pending.empty()) {
+                    const Node *hidden_node = pending.back();
+
+                    pending.pop_back();
+                    erased_entries.erase(hidden_node->get_id());
+                    for (const Node *child : hidden_node->get_children())
+                        if (visited.insert(child).second)
+                            pending.push_back(child);
                 }
             }
             for (auto erased_entry_id : erased_entries)
                 g_cache_table.erase(erased_entry_id);
             // cached_ids.clear();
             // erased_entries.clear();
+
+            // the frame has been rendered - reset the dirtiness state of each shown node
+            _clean_up_branch(tree.get_root());
+        }
+
+        /*!
+         * \brief Share cache entries between structurally identical subtrees.
+         *
+         * Previously found groups are discarded. Within each new group, the
+         * first cached member's entry replaces the other members' entries,
+         * which are freed.
+         */
+        size_t share_identical_subtrees(HMITree& tree) {
+            std::unordered_set<nid_t> dirty_ids;
+
+            g_identical_group_of.clear();
+            g_identical_groups.clear();
+            for (HMITree::dfs_iterator it = tree.dfs_begin(); it != tree.dfs_end(); ++it)
+                if (it->is_dirty() || it->has_dirty_descendants())
+                    dirty_ids.insert(it->get_id());
+
+            for (const std::vector<nid_t>& group : tree.find_identical_subtrees()) {
+                std::vector<nid_t> members;
+                std::shared_ptr<CacheEntry> shared_entry;
+
+                for (nid_t member_id : group)
+                    if (dirty_ids.find(member_id) == dirty_ids.end())
+                        members.push_back(member_id);
+                if (members.size() < 2)
+                    continue;
+
+                for (nid_t member_id : members) {
+                    auto entry_it = g_cache_table.find(member_id);
+
+                    g_identical_group_of[member_id] = members.front();
+                    g_identical_groups[members.front()].insert(member_id);
+                    if (entry_it == g_cache_table.end())
+                        continue;
+                    if (shared_entry)
+                        entry_it->second = shared_entry;
+                    else
+                        shared_entry = entry_it->second;
+                }
+            }
+            return g_identical_groups.size();
+        }
+
+        /*!
+         * \brief Drop the stale cache entries of an invalidated branch.
+         *
+         * The whole branch is traversed, since the entries of hidden
+         * branches and the previous versions below the topmost cached nodes
+         * are kept as well.
+         *
+         * \see drop_branch_entries()
+         */
+        size_t invalidate_branch(Node& top) {
+            return drop_branch_entries(top);
+        }
+
+        /*!
+         * \brief Switch the shown page.
+         *
+         * The previously shown page is hidden, hence its cache entries are
+         * kept warm (as long as it remains among the most recently shown
+         * pages). Before the first switch all pages are shown, hence every
+         * page but the new one is hidden.
+         */
+        void switch_page(HMITree& tree, nid_t page_id) {
+            Node *page = find_page(tree, page_id);
+
+            if (!page)
+                throw HMIException(&tree.get_node(page_id));
+            if (page_id == g_current_page)
+                return;
+            if (g_current_page != 0) {
+                Node *previous = find_page(tree, g_current_page);
+
+                if (previous) {
+                    previous->set_visible(false);
+                    ++g_page_transitions[g_current_page][page_id];
+                }
+            } else {
+                for (Node *other : tree.get_root().get_children())
+                    if (other != page)
+                        other->set_visible(false);
+            }
+            page->set_visible(true);
+            g_current_page = page_id;
+            if (g_page_cache_capacity > 0)
+                touch_page(tree, page_id, 0);
+        }
+
+        /*!
+         * \brief Prefetch the most likely next page.
+         *
+         * The candidates are the pages which have most frequently been
+         * switched to from the current page. The first candidate which is
+         * hidden and not warm yet (i.e. it is not among the recently shown
+         * pages or it has been updated since) is evaluated and rendered as if
+         * it were shown, and its cache entries are stored. It is placed
+         * right behind the current page in the list of warm pages.
+         */
+        nid_t prefetch_page(HMITree& tree, const DirtinessScore& score, double threshold) {
+            if (g_page_cache_capacity < 2 || g_current_page == 0)
+                return 0;
+
+            auto transitions_it = g_page_transitions.find(g_current_page);
+
+            if (transitions_it == g_page_transitions.end())
+                return 0;
+
+            std::vector<std::pair<size_t, nid_t>> candidates;
+
+            for (auto& transition : transitions_it->second)
+                candidates.push_back(std::make_pair(transition.second, transition.first));
+            std::sort(candidates.begin(), candidates.end(), std::greater<std::pair<size_t, nid_t>>());
+            for (auto& candidate : candidates) {
+                Node *page = find_page(tree, candidate.second);
+
+                if (!page || page->is_visible())
+                    continue;
+                if (std::find(g_recent_pages.begin(), g_recent_pages.end(), page->get_id()) != g_recent_pages.end()
+                        && !page->is_dirty() && !page->has_dirty_descendants())
+                    continue;  // page is already warm
+
+                std::unordered_set<const Node *> evaluated;
+                std::unordered_set<nid_t> cached_ids;
+                std::unordered_set<const Node *> visited;
+                std::vector<Node *> hidden;
+
+                if (g_debug)
+                    std::cout << "Prefetching page " << page->get_id() << std::endl;
+                _evaluate_node_dirtiness(*page, score, threshold, evaluated);
+                _refresh_branch(*page, cached_ids, visited, hidden);
+                _clean_up_branch(*page);
+                touch_page(tree, page->get_id(), 1);
+                return page->get_id();
+            }
+            return 0;
+        }
+
+        /*!
+         * \brief Drop the cached state of specific nodes.
+         *
+         * Besides their cache entries, all statistics which are kept per
+         * node id are dropped as well, since the ids of removed nodes may be
+         * leased to new nodes.
+         */
+        void invalidate_cache_entries(const std::vector<nid_t>& node_ids) {
+            for (nid_t node_id : node_ids) {
+                g_cache_table.erase(node_id);
+                g_subtree_stats.erase(node_id);
+                g_placement.erase(node_id);
+                leave_identical_group(node_id);
+                g_versioned.erase(node_id);
+                g_cache_versions_of.erase(node_id);
+            }
+        }
+
+        /*!
+         * \brief Keep a node's previous cache entry as one of its versions.
+         *
+         * \details The versions are kept most recently used first, hence <!--
+         * --> the least recently used one is freed first.
+         */
+        void stash_version(nid_t node_id, std::shared_ptr<CacheEntry> entry) {
+            if (g_cache_versions < 2)
+                return;
+
+            std::deque<std::shared_ptr<CacheEntry>>& versions = g_cache_versions_of[node_id];
+
+            if (_touch_version(versions, entry->get_source_hash()))
+                return;
+            versions.push_front(std::move(entry));
+            if (versions.size() > g_cache_versions - 1)  // one more version is in the cache table
+                versions.pop_back();
+        }
+
+        /*!
+         * \brief Take a node's previous cache entry which has been built from a given branch.
+         */
+        std::shared_ptr<CacheEntry> take_version(nid_t node_id, size_t source_hash) {
+            auto versions_it = g_cache_versions_of.find(node_id);
+
+            if (versions_it == g_cache_versions_of.end())
+                return nullptr;
+
+            std::deque<std::shared_ptr<CacheEntry>>& versions = versions_it->second;
+
+            for (auto version_it = versions.begin(); version_it != versions.end(); ++version_it) {
+                if ((*version_it)->get_source_hash() == source_hash) {
+                    std::shared_ptr<CacheEntry> version = std::move(*version_it);
+
+                    versions.erase(version_it);
+                    return version;
+                }
+            }
+            return nullptr;
         }
 
         /*!
@@ -169,8 +1164,20 @@ namespace hmi_tree_optimization {
          * Frees the dynamically allocated memory for each cache entry.
          */
         void clear_cache() noexcept {
-            for (auto& entry : g_cache_table)
-                delete entry.second;  // clear the cache
+            g_cache_table.clear();
+            g_subtree_stats.clear();
+            g_placement.clear();
+            g_budget_price = 0.0;
+            g_placement_items.clear();
+            g_placement_epoch = 0;
+            g_evaluations = 0;
+            g_identical_group_of.clear();
+            g_identical_groups.clear();
+            g_versioned.clear();
+            g_cache_versions_of.clear();
+            g_recent_pages.clear();
+            g_current_page = 0;
+            g_page_transitions.clear();
         }
     }  // namespace solution
 }  // namespace hmi_tree_optimization
@@ -17,6 +17,17 @@ namespace hmi_tree_optimization {
     //! \brief Solution to the presented optimization problem
     namespace solution {
         bool g_debug = false;
+        double g_hot_period = 2.0;
+        double g_recency_half_life = 8.0;
+        double g_frequency_weight = 0.25;
+        double g_cache_load_cost = 0.1;
+        double g_cache_store_cost = 0.2;
+        size_t g_cache_budget = 0;
+        double g_node_entry_size = 128.0;
+        size_t g_placement_period = 8;
+        bool g_weighted_counts = false;
+        size_t g_cache_versions = 1;
+        size_t g_page_cache_capacity = 2;
     }  // namespace solution
 }  // namespace hmi_tree_optimization
 
@@ -13,30 +13,37 @@
  * \version v1.0.0
  */
 
+#include <algorithm>
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
 #include <string>
+#include <utility>
 #include <vector>
 #include <queue>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "solution/config.hh"
 #include "solution/caching.hh"
 #include "std_helper/split.hh"
 #include "tree/hmi_tree.hh"
+#include "tree/cache_entry.hh"
 #include "tree/hmi_objects/hmi_view.hh"
 #include "tree/hmi_objects/hmi_widget.hh"
 #include "tree/hmi_objects/hmi_text.hh"
 #include "tree/hmi_exception.hh"
 #include "heavy_hitters/cms.hh"
+#include "heavy_hitters/interval_estimator.hh"
+#include "heavy_hitters/recency_scorer.hh"
 
 using namespace hmi_tree_optimization;
 using namespace hmi_tree_optimization::solution;
 using namespace hmi_tree_optimization::tree;
 
 namespace {
-    void add_node_from_csv(const std::string&, HMITree&);
+    NodeRecord parse_node_record(const std::string&);
+    PatchOperation parse_patch_operation(const std::string&);
 }  // anonymous namespace
 
 /*!
@@ -49,7 +56,7 @@ namespace {
  * from the project's root directory):
  *
  * \code
- * ./bin/solution {debug} {k} {errpr} {leeway}
+ * ./bin/solution {debug} {k} {errpr} {leeway} [pages] [budget] [versions] [weighted]
  * \endcode
  *
  * where:
@@ -61,7 +68,19 @@ namespace {
  *   of input items; value is between 0 and 1 (between 0% and 100%);
  *   - \a leeway: how much the frequency count of a heavy hitter may drop below the
  *   heavy hitter threshold (m / k); value is between 0 and 1 (between 0% 
- *   and 100%).
+ *   and 100%);
+ *   - \a pages: optional; how many recently shown pages are kept warm in the
+ *   page cache; value is a non-negative integer (2 by default, i.e. the shown
+ *   page and the previously shown one; 0 disables the page cache);
+ *   - \a budget: optional; how many bytes the cached branches may take up;
+ *   value is a non-negative integer (0 by default, i.e. the branches are
+ *   cached regardless of their size);
+ *   - \a versions: optional; how many cache entry versions are kept per heavy
+ *   hitter; value is a positive integer (1 by default, i.e. no previous
+ *   versions are kept);
+ *   - \a weighted: optional; indicate whether each occurrence should be
+ *   weighted by the render cost of its node's branch; value is boolean
+ *   (either 0 or 1, 0 by default).
  *
  * example (using one of the provided exemplary input files):
  *
@@ -94,7 +113,12 @@ namespace {
  * HMI tree has (excluding the root View node). Then each node must be defined
  * by one line via its parent node's id, its type, its own node id and with
  * additional arguments (which depend on the HMI tree node type). The node's
- * information is presented in CSV format.
+ * information is presented in CSV format. The nodes may be listed in any
+ * order, i.e. a child node may precede its parent node.
+ *
+ * A line of type \b R does not define a new node. Instead, it makes the
+ * existing node \a nid (alongside its whole branch) a child of node \a pnid
+ * as well, i.e. the branch is shared by both parents.
  * \note The HMI tree's root node (which is always an HMIView) should not be <!--
  * --> explicitly specified in the user's input. It always has an id of 0.
  *
@@ -103,6 +127,27 @@ namespace {
  * the following:
  * - \b print: print the current state of the HMI tree (highlights the dirty
  *   and very dirty nodes);
+ * - \b dedup: find structurally identical subtrees and let them share their
+ *   cache entries;
+ * - \b patch,{\a n}: change the HMI tree's layout; the following \a n lines
+ *   describe one structural change each (see parse_patch_operation());
+ * - \b hide,{\a nid} and \b show,{\a nid}: hide or show node \a nid
+ *   alongside its branch; hidden branches are neither evaluated nor rendered
+ *   and their updates are not counted;
+ * - \b begin and \b commit: begin and commit a transaction; the updates
+ *   in between are staged and applied all at once on commit, so that a
+ *   frame refreshed in between never shows them half applied;
+ * - \b invalidate,{\a nid}: mark the whole branch of node \a nid for
+ *   re-rendering (e.g. after a theme switch); this is not counted as an
+ *   update of any node;
+ * - \b page,{\a nid}: switch to page \a nid (a direct child of the root),
+ *   i.e. hide the current page and show page \a nid;
+ * - \b idle: simulate idle time between frames, during which the most likely
+ *   next page is prefetched (see prefetch_page());
+ * - \b prototype,{\a name},{\a nid}: register the branch of node \a nid as a
+ *   prototype called \a name;
+ * - \b instantiate,{\a name},{\a pnid}: attach a new copy of the prototype
+ *   called \a name to node \a pnid (the copy's nodes get new ids);
  * - \b refresh: simulate a frame refresh, i.e. it resets the dirtiness state
  *   of each node and runs the optimization algorithm. The latter determines
  *   which nodes are rerendered, which may be cached and which are loaded from
@@ -117,12 +162,22 @@ namespace {
  * Heavy Hitters algorithm. Furthermore, it uses two other data structures:
  * a priority queue (\b heavy_hitters_pq) and an unordered set/hash set 
  * (\b heavy_hitters_set).\n
- * The variable \b m stores the size of the input stream, required by the
- * Heavy Hitters algorithm. It is only incremented once for each dirty node
- * when refreshing the frame, i.e. it does not matter how many times a node
- * is updated between two frames - the algorithm treats this as one update.
+ * The size of the input stream \b m, required by the Heavy Hitters
+ * algorithm, is the total count of the CMS (see CMS::mass). It is only
+ * incremented once for each dirty node when refreshing the frame, i.e. it
+ * does not matter how many times a node is updated between two frames - the
+ * algorithm treats this as one update.
  * Therefore, between two frames, a node's frequency count in the CMS can
- * only be incremented once.\n 
+ * only be incremented once. The occurrences are counted when the frame is
+ * refreshed, against the nodes' state at that time. Updates of hidden nodes
+ * are not counted at all, neither are updates which do not change their node
+ * (e.g. a resent value, or a value which has been changed back within the
+ * frame).\n
+ * If \b g_weighted_counts is enabled, each occurrence is weighted by the
+ * cost of re-rendering the node's branch (i.e. its number of shown nodes, as
+ * of the latest evaluation), both in the CMS and in \b m. Therefore, \b m is
+ * the weighted size of the input stream and the expensive nodes become heavy
+ * hitters first.\n 
  * The size of the input stream is used to evaluate
  * each node and determine the heavy hitters (i.e. all nodes which occur more
  * frequently than \b m/k). All heavy hitters are added both to the set and
@@ -130,8 +185,19 @@ namespace {
  * Nodes are no longer considered heavy hitters once their frequency count
  * falls below \b ((1+leeway)*m)/k. They are removed both from
  * the set and the priority queue.\n
- * The set of all heavy hitters is then used to determine which nodes are suitable
- * for caching.
+ * Alongside the CMS, the interval between each node's consecutive
+ * occurrences (in frames) is estimated (\b intervals). Heavy hitters whose
+ * estimated period is longer than \b g_hot_period frames are updated on a
+ * slow schedule (e.g. a clock), hence they are kept cached and simply
+ * re-cached whenever they are updated.\n
+ * The lifetime counts of the CMS are slow to react to a change of the
+ * update pattern, therefore the nodes are not cached based on the set of
+ * heavy hitters directly. Instead, each node's occurrences are also recorded
+ * by a recency scorer (\b scorer) whose weight halves every
+ * \b g_recency_half_life frames. A node's dirtiness score blends its share of
+ * these recency-weighted occurrences with its share of the CMS counts
+ * (weighted by \b g_frequency_weight). Nodes whose score reaches \b 1/k are
+ * not fit for caching. The set of heavy hitters is only kept for statistics.
  *
  * \see evaluate_tree_dirtiness()
  * \see refresh_screen()
@@ -143,6 +209,14 @@ int main(int argc, char *argv[]) {
     if (argc < 5) 
         return -1;
     g_debug = std::stoi(argv[1]);
+    if (argc > 5)
+        g_page_cache_capacity = std::stoul(argv[5]);
+    if (argc > 6)
+        g_cache_budget = std::stoul(argv[6]);
+    if (argc > 7)
+        g_cache_versions = std::stoul(argv[7]);
+    if (argc > 8)
+        g_weighted_counts = std::stoi(argv[8]);
 
     int frame = 1;
     HMITree tree;
@@ -151,34 +225,119 @@ int main(int argc, char *argv[]) {
     nid_t node_id;
     nid_t hitter;
     std::vector<std::string> items;
-    size_t m = 0;  // current size of input stream
+    std::vector<NodeRecord> records;
+    std::vector<NodeRecord> references;
     size_t k = std::stoul(argv[2]);
     double errpr = std::stod(argv[3]);
     double leeway = std::stod(argv[4]);  // in %
     heavy_hitters::CMS<nid_t> cms(k, errpr);
-    auto cmp = [&cms](nid_t left, nid_t right) {
-        return cms.count(left) - cms.count(right);
+    std::unordered_map<nid_t, size_t> count_offsets;  // CMS counts of reused ids' previous nodes
+    auto count = [&](nid_t id) {
+        auto offset = count_offsets.find(id);
+
+        return offset == count_offsets.end() ? cms.count(id) : cms.count(id) - offset->second;
+    };
+    auto cmp = [&count](nid_t left, nid_t right) {  // least frequent heavy hitter on top
+        return count(left) > count(right);
     };
     std::priority_queue<nid_t, std::vector<nid_t>, decltype(cmp)> heavy_hitters_pq(cmp);
     std::unordered_set<nid_t> heavy_hitters_set;
+    std::vector<nid_t> touched;  // ids of nodes which have been dirtied by updates since the last frame
+    heavy_hitters::IntervalEstimator<nid_t> intervals;
+    heavy_hitters::RecencyScorer<nid_t> scorer(g_recency_half_life, g_frequency_weight);
+    auto count_occurrence = [&](const Node& occurrence) {
+        size_t weight = occurrence_weight(occurrence.get_id());
+
+        hitter = occurrence.get_id();
+        intervals.record(hitter, frame);
+        scorer.record(hitter, frame, weight);
+        cms.increment(hitter, weight);
+
+        size_t m = cms.mass();  // current (weighted) size of input stream
+
+        // add new heavy hitters
+        if (count(hitter) >= static_cast<double>(m) / k
+                && heavy_hitters_set.find(hitter) == heavy_hitters_set.end()) {
+            heavy_hitters_pq.push(hitter);
+            heavy_hitters_set.insert(hitter);
+        }
+        // remove irrelevant nodes which are no longer heavy hitters
+        while (!heavy_hitters_pq.empty()) {
+            hitter = heavy_hitters_pq.top();
+            if (count(hitter) < ((1 + leeway) * m) / k) {
+                heavy_hitters_pq.pop();
+                heavy_hitters_set.erase(hitter);
+            } else {
+                break;
+            }
+        }
+    };
+    auto score = [&](nid_t id) {
+        // nodes which are updated on a slow schedule stay cached
+        if (cms.mass() == 0 || intervals.period(id, frame) > g_hot_period)
+            return 0.0;
+        return scorer.score(id, frame, count(id) / static_cast<double>(cms.mass()));
+    };
+    auto forget = [&](nid_t id) {
+        // a removed node's id may be reused by a new node, which must not
+        // inherit its statistics (the CMS cannot forget, hence its current
+        // count is subtracted from the id's later estimates)
+        count_offsets[id] = cms.count(id);
+        intervals.erase(id);
+        scorer.erase(id);
+        touched.erase(std::remove(touched.begin(), touched.end(), id), touched.end());
+        if (heavy_hitters_set.erase(id)) {
+            std::vector<nid_t> remaining;
+
+            for (; !heavy_hitters_pq.empty(); heavy_hitters_pq.pop())
+                if (heavy_hitters_pq.top() != id)
+                    remaining.push_back(heavy_hitters_pq.top());
+            for (nid_t remaining_id : remaining)
+                heavy_hitters_pq.push(remaining_id);
+        }
+    };
+    const double threshold = 1.0 / k;
 
     // define the simulated HMI tree
     std::cin >> nnodes;
     std::getline(std::cin, line);  // skip newline char
+    records.reserve(nnodes);
     for (size_t i = 0; i < nnodes; ++i) {
         std::getline(std::cin, line);
-        add_node_from_csv(line, tree);
+        records.push_back(parse_node_record(line));
+        if (records.back().type == 'R') {  // references are added after all nodes
+            references.push_back(records.back());
+            records.pop_back();
+        }
     }
+    tree.build(records);
+    for (const NodeRecord& reference : references)
+        tree.add_reference(reference.parent_id, reference.id);
+    records.clear();
+    references.clear();
 
     // simulation program
     while (!std::getline(std::cin, line).eof()
             && line.compare("end") != 0) {
         if (line.compare("print") == 0) {  // print the current state of the tree
             std::cout << tree << std::endl;
+        } else if (line.compare("dedup") == 0) {  // share identical subtrees' cache entries
+            size_t ngroups = share_identical_subtrees(tree);
+
+            if (g_debug)
+                std::cout << "Found " << ngroups << " groups of identical subtrees" << std::endl;
         } else if (line.compare("refresh") == 0) {  // refresh the frame
             if (g_debug)
                 std::cout << ">>>>> Frame " << frame << " <<<<<" << std::endl;
-            evaluate_tree_dirtiness(tree, heavy_hitters_set);
+            for (nid_t touched_id : touched) {
+                Node& node = tree.get_node(touched_id);
+
+                // updates which have been reverted within the frame are not counted
+                if (node.apply_pending_update().is_dirty() && node.is_shown())
+                    count_occurrence(node);
+            }
+            touched.clear();
+            evaluate_tree_dirtiness(tree, score, threshold);
             refresh_screen(tree);
             ++frame;
             if (g_debug) {
@@ -194,42 +353,72 @@ int main(int argc, char *argv[]) {
                         << std::endl;
                 std::cout << std::endl;
             }
+        } else if (line.compare(0, 6, "patch,") == 0) {  // change the tree's layout
+            std::vector<PatchOperation> operations(std::stoul(line.substr(6)));
+
+            for (PatchOperation& operation : operations) {
+                std::getline(std::cin, line);
+                operation = parse_patch_operation(line);
+            }
+            std::vector<nid_t> invalidated = tree.apply_patch(operations);
+
+            invalidate_cache_entries(invalidated);
+            for (nid_t invalidated_id : invalidated)
+                forget(invalidated_id);
+        } else if (line.compare(0, 5, "hide,") == 0) {  // hide a branch
+            tree.set_visibility(std::stoul(line.substr(5)), false);
+        } else if (line.compare(0, 5, "show,") == 0) {  // show a hidden branch
+            tree.set_visibility(std::stoul(line.substr(5)), true);
+        } else if (line.compare("begin") == 0) {  // stage the following updates
+            tree.begin();
+        } else if (line.compare("commit") == 0) {  // apply the staged updates at once
+            std::vector<nid_t> dirtied = tree.commit();
+
+            touched.insert(touched.end(), dirtied.begin(), dirtied.end());
+        } else if (line.compare(0, 11, "invalidate,") == 0) {  // re-render a whole branch
+            size_t ndropped = invalidate_branch(tree.invalidate_subtree(std::stoul(line.substr(11))));
+
+            if (g_debug)
+                std::cout << "Dropped " << ndropped << " stale cache entries" << std::endl;
+        } else if (line.compare(0, 5, "page,") == 0) {  // switch the shown page
+            switch_page(tree, std::stoul(line.substr(5)));
+        } else if (line.compare("idle") == 0) {  // prefetch the next page in idle time
+            prefetch_page(tree, score, threshold);
+        } else if (line.compare(0, 10, "prototype,") == 0) {  // register a prototype
+            items = std_helper::split(line, ",");
+            tree.register_prototype(items.at(1), std::stoul(items.at(2)));
+        } else if (line.compare(0, 12, "instantiate,") == 0) {  // instantiate a prototype
+            items = std_helper::split(line, ",");
+            node_id = tree.instantiate(items.at(1), std::stoul(items.at(2)));
+            if (g_debug)
+                std::cout << "Instantiated prototype " << items[1]
+                    << " as node " << node_id << std::endl;
         } else {  // update a node
             items = std_helper::split(line, ",");
             node_id = std::stoul(items[0]);
             items.erase(items.begin());
 
-            if (!tree.get_node(node_id).is_dirty()) {
-                hitter = node_id;
-                cms.increment(hitter);
-                ++m;
-                // add new heavy hitters
-                if (cms.count(hitter) >= static_cast<double>(m) / k
-                        && heavy_hitters_set.find(hitter) == heavy_hitters_set.end()) {
-                    heavy_hitters_pq.push(hitter);
-                    heavy_hitters_set.insert(hitter);
-                }
-                // remove irrelevant nodes which are no longer heavy hitters
-                while (!heavy_hitters_pq.empty()) {
-                    hitter = heavy_hitters_pq.top();
-                    if (cms.count(hitter) < ((1 + leeway) * m) / k) {
-                        heavy_hitters_pq.pop();
-                        heavy_hitters_set.erase(hitter);
-                    } else {
-                        break;
-                    }
-                }
+            if (tree.in_transaction()) {
+                tree.stage_update(node_id, items);
+                continue;
             }
 
-            tree.get_node(node_id).update(items);
+            Node& node = tree.get_node(node_id);
+            bool was_dirty = node.is_dirty();
+
+            node.update(std::move(items));
+            if (!was_dirty && node.is_dirty())  // unchanged values are not counted
+                touched.push_back(node_id);
         }
     }
 
     // clean up and final debug messages
-    clear_cache();
+    clear_cache();  // cache entries must be freed before the static memory pools are destroyed
     if (g_debug) {
         std::cout << ">>>>> CMS <<<<<" << std::endl;
         cms.print();
+        intervals.print(frame);
+        scorer.print(frame);
         std::cout << ">>>>> Heavy hitters <<<<<" << std::endl;
         while (!heavy_hitters_pq.empty()) {
             node_id = heavy_hitters_pq.top();
@@ -238,41 +427,80 @@ int main(int argc, char *argv[]) {
             heavy_hitters_set.erase(node_id);
         }
         std::cout << std::endl;
+        std::cout << ">>>>> Memory pools <<<<<" << std::endl;
+        Node::pool().print();
+        CacheEntry::pool().print();
     }
     return 0;
 }
 
 namespace {
     /*!
-     * \brief Create an HMI tree node from a line of input
+     * \brief Parse the description of an HMI tree node from a line of input
      *
      * That line of input must contain all relevant information to an HMI
      * tree node in CSV format.
      *
      * \see hmi_tree_optimization::std_helper::split()
-     * \see hmi_tree_optimization::tree::HMIWidget
-     * \see hmi_tree_optimization::tree::HMIText
-     * \see hmi_tree_optimization::tree::HMITree
+     * \see hmi_tree_optimization::tree::NodeRecord
+     * \see hmi_tree_optimization::tree::HMITree::build
      *
      * \note For exemplary input check the text files in \b tmp/inputs/.
      */
-    void add_node_from_csv(const std::string& line, HMITree& tree) {
-        Node *node;
+    NodeRecord parse_node_record(const std::string& line) {
         std::vector<std::string> items = std_helper::split(line, ",");
-        nid_t parent_id = std::stoul(items[0]);
-        const std::string& type = items[1];
-        nid_t node_id = std::stoul(items[2]);
+        NodeRecord record;
+
+        if (items.size() < 3 || items[1].size() != 1)
+            throw HMIException(nullptr);
+        record.parent_id = std::stoul(items[0]);
+        record.type = items[1][0];
+        record.id = std::stoul(items[2]);
+        record.args.assign(items.begin() + 3, items.end());
+        return record;
+    }
 
-        if (type.compare("W") == 0) {
-            node = new HMIWidget(node_id);
-        } else if (type.compare("T") == 0) {
-            const std::string& content = items[3];
+    /*!
+     * \brief Parse a structural change of an HMI tree from a line of input
+     *
+     * The line must be in one of the following CSV formats:
+     * - \b add,{\a pnid},{\a type},{\a nid},[\a arg1, \a arg2...]: create a
+     *   new node (same format as when building the tree);
+     * - \b remove,{\a nid}: remove node \a nid alongside its branch;
+     * - \b move,{\a nid},{\a pnid}: move node \a nid (alongside its branch)
+     *   under node \a pnid;
+     * - \b retype,{\a nid},{\a type},[\a arg1, \a arg2...]: replace node
+     *   \a nid by a node of another type.
+     *
+     * \see hmi_tree_optimization::tree::PatchOperation
+     * \see hmi_tree_optimization::tree::HMITree::apply_patch
+     */
+    PatchOperation parse_patch_operation(const std::string& line) {
+        size_t separator = line.find(',');
+        std::string kind = line.substr(0, separator);
+        std::string rest = separator == std::string::npos ? "" : line.substr(separator + 1);
+        std::vector<std::string> items = std_helper::split(rest, ",");
+        PatchOperation operation;
 
-            node = new HMIText(node_id, content);
+        if (kind.compare("add") == 0) {
+            operation.kind = PatchOperation::Kind::add;
+            operation.node = parse_node_record(rest);
+        } else if (kind.compare("remove") == 0) {
+            operation.kind = PatchOperation::Kind::remove;
+            operation.node.id = std::stoul(items.at(0));
+        } else if (kind.compare("move") == 0) {
+            operation.kind = PatchOperation::Kind::move;
+            operation.node.id = std::stoul(items.at(0));
+            operation.node.parent_id = std::stoul(items.at(1));
+        } else if (kind.compare("retype") == 0 && items.size() >= 2 && items[1].size() == 1) {
+            operation.kind = PatchOperation::Kind::retype;
+            operation.node.id = std::stoul(items[0]);
+            operation.node.type = items[1][0];
+            operation.node.args.assign(items.begin() + 2, items.end());
         } else {
             throw HMIException(nullptr);
         }
-        tree.add_node(parent_id, node);
+        return operation;
     }
 }  // anonymous namespace
 
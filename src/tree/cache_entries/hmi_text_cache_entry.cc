@@ -16,6 +16,9 @@
 #include <sstream>
 #include <unordered_map>
 
+#include "tree/string_table.hh"
+#include "tree/hmi_objects/hmi_text.hh"
+
 //! \namespace hmi_tree_optimization
 //! \brief Project namespace
 namespace hmi_tree_optimization {
@@ -27,16 +30,18 @@ namespace hmi_tree_optimization {
          *
          * Stores the values of the node's attributes to the attributes map
          * in heap memory. The allocated memory should only be freed by the
-         * created cache entry.
+         * created cache entry. A reference to the interned content is held
+         * as long as the entry refers to it.
          *
          * \see CacheEntry
          * \see HMIText
          * \see HMITextCacheEntry::~HMITextCacheEntry
          */
-        HMITextCacheEntry::HMITextCacheEntry(const std::string& content) {
+        HMITextCacheEntry::HMITextCacheEntry(sid_t content) {
             std::unordered_map<std::string, void *>& attributes = get_attributes();
 
-            attributes.insert(std::make_pair("content_", new std::string(content)));
+            attributes.insert(std::make_pair("content_", new sid_t(content)));
+            HMIText::strings().retain(content);
         }
 
         /*!
@@ -52,7 +57,37 @@ namespace hmi_tree_optimization {
         HMITextCacheEntry::~HMITextCacheEntry() noexcept {
             std::unordered_map<std::string, void *>& attributes = get_attributes();
 
-            delete static_cast<std::string *>(attributes.at("content_"));
+            sid_t *content = static_cast<sid_t *>(attributes.at("content_"));
+
+            HMIText::strings().release(*content);
+            delete content;
+        }
+
+        /*!
+         * \brief Overwrite the cached 'content_' attribute.
+         *
+         * The already allocated copy of the attribute is assigned the new
+         * value, i.e. no memory is allocated. The reference to the previous
+         * content is given back.
+         */
+        HMITextCacheEntry& HMITextCacheEntry::assign(sid_t content) {
+            std::unordered_map<std::string, void *>& attributes = get_attributes();
+            sid_t *cached = static_cast<sid_t *>(attributes.find("content_")->second);
+
+            HMIText::strings().retain(content);
+            HMIText::strings().release(*cached);
+            *cached = content;
+            return *this;
+        }
+
+        /*!
+         * \brief Estimate the memory taken up by this HMITextCacheEntry.
+         *
+         * \details The interned content is shared by all of its text nodes <!--
+         * --> and entries, hence only its id is counted.
+         */
+        size_t HMITextCacheEntry::size() const noexcept {
+            return CacheEntry::size() + sizeof(sid_t);
         }
 
         /*!
@@ -63,7 +98,8 @@ namespace hmi_tree_optimization {
         std::string HMITextCacheEntry::repr() const {
             const std::unordered_map<std::string, void *>& attributes = get_attributes();
             std::ostringstream res;
-            const std::string& content = *static_cast<std::string *>(attributes.at("content_"));
+            const std::string& content = HMIText::strings().lookup(
+                    *static_cast<sid_t *>(attributes.at("content_")));
             
             res << "HMITextCacheEntry{"
                 << "content=" << content
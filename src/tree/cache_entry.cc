@@ -13,12 +13,36 @@
 #include <unordered_map>
 #include <string>
 
+#include "tree/memory_pool.hh"
+
 //! \namespace hmi_tree_optimization
 //! \brief Project namespace
 namespace hmi_tree_optimization {
     //! \namespace tree
     //! \brief Contains a bare bones simulated HMI tree
     namespace tree {
+        /*!
+         * \brief Construct cache entry.
+         */
+        CacheEntry::CacheEntry() noexcept
+            : source_hash_(0) {
+        }
+
+        /*!
+         * \brief Get the hash of the branch which the entry has been built from.
+         */
+        size_t CacheEntry::get_source_hash() const noexcept {
+            return source_hash_;
+        }
+
+        /*!
+         * \brief Record the hash of the branch which the entry is built from.
+         */
+        CacheEntry& CacheEntry::set_source_hash(size_t source_hash) noexcept {
+            source_hash_ = source_hash;
+            return *this;
+        }
+
         /*!
          * \brief Get map of attribute values copies.
          */
@@ -27,12 +51,57 @@ namespace hmi_tree_optimization {
             return attributes_;
         }
 
+        /*!
+         * \brief Estimate the memory taken up by this cache entry.
+         *
+         * Counts the entry itself and the attribute map's buckets and
+         * elements. The attribute values are counted by the subclasses,
+         * since only they know their types.
+         */
+        size_t CacheEntry::size() const noexcept {
+            constexpr size_t element_size = sizeof(std::pair<const std::string, void *>)
+                + 2 * sizeof(void *);  // map node: element, link and cached hash
+
+            return sizeof(CacheEntry)
+                + attributes_.bucket_count() * sizeof(void *)
+                + attributes_.size() * element_size;
+        }
+
         /*!
          * \brief Destroy cache entry.
          */
         CacheEntry::~CacheEntry() noexcept {
         }
 
+        /*!
+         * \brief Allocate memory for a cache entry from the cache entry pool
+         *
+         * Cache entries are continuously created and destroyed when the
+         * screen is refreshed. Serving them from a pool keeps the heap from
+         * fragmenting.
+         */
+        void *CacheEntry::operator new(size_t size) {
+            return pool().allocate(size);
+        }
+
+        /*!
+         * \brief Return a cache entry's memory to the cache entry pool
+         */
+        void CacheEntry::operator delete(void *ptr, size_t size) noexcept {
+            pool().deallocate(ptr, size);
+        }
+
+        /*!
+         * \brief Access the memory pool which serves all cache entries
+         *
+         * \details The pool is created on first use.
+         */
+        MemoryPool& CacheEntry::pool() {
+            static MemoryPool cache_entry_pool("cache entries");
+
+            return cache_entry_pool;
+        }
+
         /*!
          * \brief Access map of attribute values copies.
          */
@@ -10,12 +10,14 @@
 
 #include "tree/hmi_objects/hmi_text.hh"
 
+#include <functional>
 #include <string>
 #include <sstream>
 
 #include "tree/node.hh"
 #include "tree/cache_entry.hh"
 #include "tree/cache_entries/hmi_text_cache_entry.hh"
+#include "tree/string_table.hh"
 
 //! \namespace hmi_tree_optimization
 //! \brief Project namespace
@@ -26,9 +28,36 @@ namespace hmi_tree_optimization {
         /*!
          * \brief Construct HMI text node
          */
-        HMIText::HMIText(nid_t id, const std::string& content) noexcept
+        HMIText::HMIText(nid_t id, const std::string& content)
+            : Node(id),
+              content_(strings().intern(content)) {
+        }
+
+        /*!
+         * \brief Construct HMI text node from interned content
+         */
+        HMIText::HMIText(nid_t id, sid_t content) noexcept
             : Node(id),
               content_(content) {
+            strings().retain(content_);
+        }
+
+        /*!
+         * \brief Destroy HMI text node
+         */
+        HMIText::~HMIText() noexcept {
+            strings().release(content_);
+        }
+
+        /*!
+         * \brief Access the string table which interns all text contents
+         *
+         * \details The table is created on first use.
+         */
+        StringTable& HMIText::strings() {
+            static StringTable text_strings;
+
+            return text_strings;
         }
 
         /*!
@@ -42,7 +71,7 @@ namespace hmi_tree_optimization {
             res << (is_dirty() ? "*" : "")
                 << "{T|" 
                 << get_id() 
-                << "|'" << content_ 
+                << "|'" << get_content()
                 << "'}";
             return res.str();
         }
@@ -59,7 +88,7 @@ namespace hmi_tree_optimization {
                 << "id=" << get_id()
                 << ", d=" << is_dirty()
                 << ", count(parents)=" << get_parents().size()
-                << ", content='" << content_ << '\''
+                << ", content='" << get_content() << '\''
                 << "}";
             return res.str();
         }
@@ -76,25 +105,48 @@ namespace hmi_tree_optimization {
         /*!
          * \brief Get text content of HMI text node
          */
-        const std::string& HMIText::get_content() const noexcept {
+        const std::string& HMIText::get_content() const {
+            return strings().lookup(content_);
+        }
+
+        /*!
+         * \brief Get id of the interned text content of HMI text node
+         */
+        sid_t HMIText::get_content_id() const noexcept {
             return content_;
         }
 
         /*!
          * \brief Set text content of HMI text node
          */
-        HMIText& HMIText::set_content(const std::string& content) noexcept {
-            content_ = content;
+        HMIText& HMIText::set_content(const std::string& content) {
+            sid_t old_content = content_;
+
+            content_ = strings().intern(content);
+            strings().release(old_content);
             return *this;
         }
 
         /*!
          * \brief Apply update parameters to this HMI text
          *
-         * \details parameters[0] is expected to be the new text content
+         * \details parameters[0] is expected to be the new text content. <!--
+         * --> No memory is allocated if it has already been interned. The <!--
+         * --> new content is interned before the old one is released, so an <!--
+         * --> unchanged content is never removed from the table.
          */
         void HMIText::apply_update(const std::vector<std::string>& parameters) {
-            content_ = parameters[0];
+            set_content(parameters[0]);
+        }
+
+        /*!
+         * \brief Check whether update parameters differ from the text's content
+         *
+         * \details The new content is compared to the interned one, i.e. <!--
+         * --> nothing is interned.
+         */
+        bool HMIText::is_changed_by(const std::vector<std::string>& parameters) const {
+            return parameters.empty() || parameters[0] != strings().lookup(content_);
         }
 
         /*!
@@ -110,7 +162,42 @@ namespace hmi_tree_optimization {
         void HMIText::use_cache_entry(const CacheEntry *entry) {
             const std::unordered_map<std::string, void *>& attributes = entry->get_attributes();
 
-            content_ = *static_cast<std::string *>(attributes.at("content_"));
+            sid_t old_content = content_;
+
+            content_ = *static_cast<sid_t *>(attributes.at("content_"));
+            strings().retain(content_);
+            strings().release(old_content);
+        }
+
+        /*!
+         * \brief Overwrite a cache entry with the text's current state
+         *
+         * \see HMITextCacheEntry::assign
+         */
+        void HMIText::update_cache_entry(CacheEntry& entry) {
+            static_cast<HMITextCacheEntry&>(entry).assign(content_);
+        }
+
+        /*!
+         * \brief Hash the text's own content
+         *
+         * \details The content itself is hashed rather than its id. Ids of <!--
+         * --> removed strings are reused, hence the same id may stand for <!--
+         * --> different contents over time, while hashes of former contents <!--
+         * --> are still held by subtree hashes and cache entries.
+         */
+        size_t HMIText::hash_content() const noexcept {
+            return std::hash<std::string>()(strings().lookup(content_));
+        }
+
+        /*!
+         * \brief Create a detached copy of this text
+         *
+         * \details The copy refers to the same interned content, i.e. the <!--
+         * --> content is neither copied nor looked up.
+         */
+        Node *HMIText::clone_node(nid_t id) const {
+            return new HMIText(id, content_);
         }
     }  // namespace tree
 }  // namespace hmi_tree_optimization
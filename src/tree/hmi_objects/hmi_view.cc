@@ -89,6 +89,19 @@ namespace hmi_tree_optimization {
         }
 #pragma GCC diagnostic pop
 
+        /*!
+         * \brief Check whether update parameters differ from the view's state
+         *
+         * \details Updates are not interpreted by an HMI view, hence each one <!--
+         * --> is conservatively considered a change.
+         */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+        bool HMIView::is_changed_by(const std::vector<std::string>& parameters) const {
+            return true;
+        }
+#pragma GCC diagnostic pop
+
         /*!
          * \brief Generate an HMI view cache entry
          *
@@ -108,6 +121,33 @@ namespace hmi_tree_optimization {
         void HMIView::use_cache_entry(const CacheEntry *entry) {
         }
 #pragma GCC diagnostic pop
+
+        /*!
+         * \brief Overwrite a cache entry with the view's current state
+         *
+         * \details Does nothing.
+         */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+        void HMIView::update_cache_entry(CacheEntry& entry) {
+        }
+#pragma GCC diagnostic pop
+
+        /*!
+         * \brief Hash the view's own content
+         *
+         * \details An HMI view has no content of its own.
+         */
+        size_t HMIView::hash_content() const noexcept {
+            return 0;
+        }
+
+        /*!
+         * \brief Create a detached copy of this view
+         */
+        Node *HMIView::clone_node(nid_t id) const {
+            return new HMIView(id);
+        }
     }  // namespace tree
 }  // namespace hmi_tree_optimization
 
@@ -84,6 +84,19 @@ namespace hmi_tree_optimization {
         }
 #pragma GCC diagnostic pop
 
+        /*!
+         * \brief Check whether update parameters differ from the widget's state
+         *
+         * \details Updates are not interpreted by an HMI widget, hence each one <!--
+         * --> is conservatively considered a change.
+         */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+        bool HMIWidget::is_changed_by(const std::vector<std::string>& parameters) const {
+            return true;
+        }
+#pragma GCC diagnostic pop
+
         /*!
          * \brief Generate an HMI widget cache entry
          *
@@ -103,6 +116,33 @@ namespace hmi_tree_optimization {
         void HMIWidget::use_cache_entry(const CacheEntry *entry) {
         }
 #pragma GCC diagnostic pop
+
+        /*!
+         * \brief Overwrite a cache entry with the widget's current state
+         *
+         * \details Does nothing.
+         */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+        void HMIWidget::update_cache_entry(CacheEntry& entry) {
+        }
+#pragma GCC diagnostic pop
+
+        /*!
+         * \brief Hash the widget's own content
+         *
+         * \details An HMI widget has no content of its own.
+         */
+        size_t HMIWidget::hash_content() const noexcept {
+            return 0;
+        }
+
+        /*!
+         * \brief Create a detached copy of this widget
+         */
+        Node *HMIWidget::clone_node(nid_t id) const {
+            return new HMIWidget(id);
+        }
     }  // namespace tree
 }  // namespace hmi_tree_optimization
 
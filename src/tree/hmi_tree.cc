@@ -10,12 +10,18 @@
 
 #include "tree/hmi_tree.hh"
 
-#include <cstdlib>
+#include <algorithm>
 #include <iostream>
-#include <limits>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "tree/node.hh"
 #include "tree/hmi_exception.hh"
+#include "tree/hmi_objects/hmi_widget.hh"
+#include "tree/hmi_objects/hmi_text.hh"
 
 //! \namespace hmi_tree_optimization
 //! \brief Project namespace
@@ -27,24 +33,172 @@ namespace hmi_tree_optimization {
             /*!
              * \brief Print a branch of a tree to an output stream.
              *
+             * A shared branch is fully printed only once. Each other
+             * reference to it is printed as a single line, prefixed by '&'.
+             * Hidden nodes are prefixed by '~'.
+             *
              * \param node Top node of branch to print.
+             * \param depth Depth of top node in tree.
+             * \param printed Nodes which have already been printed.
              * \param out Output stream where node is printed.
              */
-            void print_branch(const Node& node, std::ostream& out) noexcept {
-                if (node.get_id() != 0) {
-                    for (size_t p = 0; p < node.nall_parents() - 1; ++p)
+            void print_branch(const Node& node, size_t depth, 
+                    std::unordered_set<const Node *>& printed, std::ostream& out) noexcept {
+                bool reference = !printed.insert(&node).second;
+
+                if (depth > 0) {
+                    for (size_t p = 0; p < depth - 1; ++p)
                         out << " │   ";
                     out << " └──";
                 }
-                out << (node.is_very_dirty() ? "%" : "")
+                out << (reference ? "&" : "")
+                    << (node.is_visible() ? "" : "~")
+                    << (node.is_very_dirty() ? "%" : "")
                     << (node.is_dirty() ? "*" : "") 
                     << node.to_letter() << "│" << node.get_id() 
                     << std::endl;
+                if (reference)
+                    return;
                 for (const auto& child : node.get_children())
-                    print_branch(*child, out);
+                    print_branch(*child, depth + 1, printed, out);
+            }
+
+            /*!
+             * \brief Check whether a node is another node or one of its ancestors
+             *
+             * \param node Node whose ancestors are searched.
+             * \param ancestor Potential ancestor.
+             *
+             * \return True if the given ancestor is the node itself or one <!--
+             * --> of its (direct or indirect) parents. False otherwise.
+             */
+            bool is_self_or_ancestor(const Node& node, const Node& ancestor) {
+                std::unordered_set<const Node *> visited;
+                std::vector<const Node *> pending(1, &node);
+
+                while (!pending.empty()) {
+                    const Node *current = pending.back();
+
+                    pending.pop_back();
+                    if (current == &ancestor)
+                        return true;
+                    for (const Node *parent : current->get_parents())
+                        if (visited.insert(parent).second)
+                            pending.push_back(parent);
+                }
+                return false;
+            }
+
+            /*!
+             * \brief Resolve the parents of a node to their mutable tree nodes
+             *
+             * \param node Node whose parents are resolved.
+             * \param index Maps node ids to tree nodes.
+             * \return The parents of the node, as indexed by the tree.
+             * \throws HMIException If a parent was not attached via the tree.
+             */
+            std::vector<Node *> indexed_parents(Node& node, const std::unordered_map<nid_t, Node *>& index) {
+                std::vector<Node *> parents;
+
+                for (const Node *parent : node.get_parents()) {
+                    auto found = index.find(parent->get_id());
+
+                    if (found == index.end() || found->second != parent)
+                        throw HMIException(&node);  // parent unknown to the tree
+                    parents.push_back(found->second);
+                }
+                return parents;
+            }
+
+            /*!
+             * \brief Detach a node from all of its parents, marking them as dirty
+             *
+             * \param node Node to detach.
+             * \param index Maps node ids to tree nodes.
+             * \throws HMIException If a parent was not attached via the tree (the
+             * <!-- --> node is left untouched).
+             */
+            void detach_from_parents(Node& node, const std::unordered_map<nid_t, Node *>& index) {
+                for (Node *parent : indexed_parents(node, index))
+                    parent->remove_child(node).mark_as_dirty();
+            }
+
+            /*!
+             * \brief Hashes the canonical key of a subtree
+             */
+            struct SubtreeKeyHash {
+                size_t operator()(const std::vector<size_t>& key) const noexcept {
+                    size_t hash = key.size();
+
+                    for (size_t value : key)
+                        hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+                    return hash;
+                }
+            };
+
+            /*!
+             * \brief Assign a canonical class to each subtree of a branch
+             *
+             * The canonical key of a subtree consists of its top node's type and
+             * content hash, followed by the sorted classes of its children.
+             * Subtrees with equal keys are identical and share a class.
+             *
+             * \param node Top node of branch.
+             * \param classes Maps already classified nodes to their classes.
+             * \param canonical Maps canonical keys to their classes.
+             *
+             * \return The branch's class.
+             */
+            size_t classify_branch(const Node& node,
+                    std::unordered_map<const Node *, size_t>& classes,
+                    std::unordered_map<std::vector<size_t>, size_t, SubtreeKeyHash>& canonical) {
+                auto found = classes.find(&node);
+
+                if (found != classes.end())  // shared branch
+                    return found->second;
+
+                std::vector<size_t> key;
+
+                key.reserve(node.get_children().size() + 2);
+                key.push_back(static_cast<size_t>(node.to_letter()));
+                key.push_back(node.content_hash());
+                for (const Node *child : node.get_children())
+                    key.push_back(classify_branch(*child, classes, canonical));
+                std::sort(key.begin() + 2, key.end());  // children are unordered
+
+                size_t nclasses = canonical.size();
+                size_t node_class = canonical.emplace(std::move(key), nclasses).first->second;
+
+                classes.emplace(&node, node_class);
+                return node_class;
+            }
+
+            /*!
+             * \brief Create a new (detached) node from its description
+             *
+             * If the record's type is unknown or its arguments are missing,
+             * an HMIException is thrown.
+             *
+             * \param record Description of node to create.
+             *
+             * \return Pointer to dynamically allocated node.
+             */
+            Node *create_node(const NodeRecord& record) {
+                switch (record.type) {
+                    case 'W':
+                        return new HMIWidget(record.id);
+                    case 'T':
+                        if (record.args.empty())
+                            throw HMIException(nullptr);
+                        return new HMIText(record.id, record.args[0]);
+                    default:
+                        throw HMIException(nullptr);
+                }
             }
         }  // anonymous namespace
 
+        constexpr nid_t HMITree::max_dense_gap;  /*!< Farthest an id may lie beyond the bitmap to extend it. */
+
         using dfs_iterator = HMITree::dfs_iterator;
         using bfs_iterator = HMITree::bfs_iterator;
 
@@ -141,7 +295,9 @@ namespace hmi_tree_optimization {
                 return;
 
             for (Node *ch : element_->get_children())
-                owner_.it_container_.push_back(ch);
+                // shared branches are visited once (only they need tracking)
+                if (ch->get_parents().size() < 2 || owner_.it_visited_.insert(ch).second)
+                    owner_.it_container_.push_back(ch);
         }
 
         /*!
@@ -252,7 +408,9 @@ namespace hmi_tree_optimization {
                 return;
 
             for (Node *ch : element_->get_children())
-                owner_.it_container_.push_back(ch);
+                // shared branches are visited once (only they need tracking)
+                if (ch->get_parents().size() < 2 || owner_.it_visited_.insert(ch).second)
+                    owner_.it_container_.push_back(ch);
         }
 
         /*!
@@ -275,18 +433,24 @@ namespace hmi_tree_optimization {
          *
          * \details Leases the root node's id (which is '0' by default).
          */
-        HMITree::HMITree() noexcept
-            : root_(0) {
-            id_pool_.insert(0);
+        HMITree::HMITree()
+            : root_(0),
+              next_nid_(0),
+              in_transaction_(false) {
+            lease_free_nid(0);
+            index_.emplace(root_.get_id(), &root_);
         }
 
         /*!
          * \brief Attach a new child node to one of the tree's other existing nodes
          *
+         * The new node's whole branch is indexed by id.
+         *
          * \see Node::add_child
          */
         HMITree& HMITree::add_node(nid_t parent_id, Node *node) {
             get_node(parent_id).add_child(node);
+            index_branch(*node);
             return *this;
         }
 
@@ -311,14 +475,415 @@ namespace hmi_tree_optimization {
             return add_node(parent_node.get_id(), &node);
         }
 
+        /*!
+         * \brief Create and attach many new nodes to the tree at once
+         *
+         * The records are first grouped by their parent id. Starting from the
+         * tree's existing nodes, the records are then put in top-down order,
+         * i.e. each parent comes before its children. Records which cannot be
+         * reached this way either have an unknown parent or are part of a
+         * parent cycle.
+         *
+         * Only after all records have been validated and all nodes have been
+         * created, the nodes are linked to their parents.
+         *
+         * Siblings are created and linked in the order of their records,
+         * hence the result does not depend on the standard library's hashing.
+         *
+         * \details Node ids are resolved via the tree's index instead of <!--
+         * --> searching the tree for each parent. Hence, building takes time <!--
+         * --> linear in the number of records only.
+         */
+        HMITree& HMITree::build(const std::vector<NodeRecord>& records) {
+            std::unordered_map<nid_t, std::vector<size_t>> records_by_parent;
+            std::unordered_set<nid_t> record_ids;
+            std::vector<size_t> order;  // record indices in top-down order
+
+            record_ids.reserve(records.size());
+            for (size_t r = 0; r < records.size(); ++r) {
+                if (is_nid_leased(records[r].id) || index_.find(records[r].id) != index_.end()
+                        || !record_ids.insert(records[r].id).second)
+                    throw HMIException(nullptr);  // id already taken
+                records_by_parent[records[r].parent_id].push_back(r);
+            }
+
+            order.reserve(records.size());
+            for (size_t r = 0; r < records.size(); ++r)
+                if (index_.find(records[r].parent_id) != index_.end())
+                    order.push_back(r);
+            for (size_t i = 0; i < order.size(); ++i) {
+                auto group = records_by_parent.find(records[order[i]].id);
+
+                if (group != records_by_parent.end())
+                    order.insert(order.end(), group->second.begin(), group->second.end());
+            }
+            if (order.size() != records.size())
+                throw HMIException(nullptr);  // unknown parent or parent cycle
+
+            std::vector<Node *> nodes;
+
+            nodes.reserve(records.size());
+            try {
+                for (size_t r : order)
+                    nodes.push_back(create_node(records[r]));
+                index_.reserve(index_.size() + records.size());
+            } catch (...) {
+                for (Node *node : nodes)
+                    delete node;
+                throw;
+            }
+
+            for (size_t i = 0; i < order.size(); ++i) {
+                index_.emplace(records[order[i]].id, nodes[i]);
+                index_.find(records[order[i]].parent_id)->second->add_child(nodes[i]);  // parents come first
+                lease_free_nid(records[order[i]].id);
+            }
+            return *this;
+        }
+
+        /*!
+         * \brief Reference an existing branch from another node
+         *
+         * The reference would create a cycle if the parent node was the target
+         * node itself or any of its (direct or indirect) children. Therefore,
+         * the parent's ancestors are searched for the target node.
+         */
+        HMITree& HMITree::add_reference(nid_t parent_id, nid_t target_id) {
+            Node& parent = get_node(parent_id);
+            Node& target = get_node(target_id);
+
+            if (&target == &root_ || is_self_or_ancestor(parent, target))
+                throw HMIException(&target);  // reference would create a cycle
+            parent.add_child(target);
+            return *this;
+        }
+
+        /*!
+         * \brief Apply a structural diff to the tree's layout
+         *
+         * The tree's index is kept up to date while applying the operations,
+         * hence the whole patch takes time linear in the size of the changes.
+         *
+         * A removed branch is torn down top-down: each node is detached from
+         * its children and every child which is left without any parent is
+         * removed as well. Branches which are shared with other parts of
+         * the tree are therefore kept.
+         */
+        std::vector<nid_t> HMITree::apply_patch(const std::vector<PatchOperation>& operations) {
+            std::vector<nid_t> invalidated;
+
+            auto lookup = [this](nid_t id) -> Node * {
+                auto found = index_.find(id);
+
+                if (found == index_.end())
+                    throw HMIException(nullptr);  // unknown node
+                return found->second;
+            };
+
+            for (const PatchOperation& operation : operations) {
+                const NodeRecord& record = operation.node;
+
+                switch (operation.kind) {
+                case PatchOperation::Kind::add: {
+                    Node& parent = *lookup(record.parent_id);
+
+                    auto taken = index_.find(record.id);
+
+                    if (taken != index_.end())
+                        throw HMIException(taken->second);  // id already taken
+                    if (is_nid_leased(record.id))
+                        throw HMIException(nullptr);  // id leased by a node yet to be attached
+
+                    Node *node = create_node(record);
+
+                    index_.emplace(record.id, node);
+                    lease_free_nid(record.id);
+                    parent.add_child(node->mark_as_dirty());
+                    break;
+                }
+                case PatchOperation::Kind::remove: {
+                    Node *node = lookup(record.id);
+                    std::vector<Node *> removed(1, node);
+
+                    if (node == &root_)
+                        throw HMIException(node);
+                    detach_from_parents(*node, index_);
+                    for (size_t i = 0; i < removed.size(); ++i) {
+                        const std::unordered_set<Node *> children(removed[i]->get_children());
+
+                        for (Node *child : children) {
+                            removed[i]->remove_child(child);
+                            if (child->get_parents().empty())
+                                removed.push_back(child);
+                        }
+                    }
+                    for (Node *removed_node : removed) {
+                        index_.erase(removed_node->get_id());
+                        release_nid(removed_node->get_id());
+                        invalidated.push_back(removed_node->get_id());
+                        delete removed_node;
+                    }
+                    break;
+                }
+                case PatchOperation::Kind::move: {
+                    Node *node = lookup(record.id);
+                    Node& parent = *lookup(record.parent_id);
+
+                    if (node == &root_ || is_self_or_ancestor(parent, *node))
+                        throw HMIException(node);  // cannot move a branch into itself
+                    detach_from_parents(*node, index_);
+                    parent.add_child(node).mark_as_dirty();
+                    break;
+                }
+                case PatchOperation::Kind::retype: {
+                    Node *node = lookup(record.id);
+
+                    if (node == &root_)
+                        throw HMIException(node);
+
+                    const std::vector<Node *> parents(indexed_parents(*node, index_));
+                    Node *replacement = create_node(record);
+                    const std::unordered_set<Node *> children(node->get_children());
+
+                    for (Node *child : children) {
+                        node->remove_child(child);
+                        replacement->add_child(child);
+                    }
+                    for (Node *parent : parents) {
+                        parent->remove_child(node);
+                        parent->add_child(replacement->mark_as_dirty());
+                    }
+                    index_[record.id] = replacement;
+                    invalidated.push_back(record.id);
+                    delete node;
+                    break;
+                }
+                }
+            }
+            return invalidated;
+        }
+
+        /*!
+         * \brief Show or hide an existing tree node (alongside its branch)
+         */
+        HMITree& HMITree::set_visibility(nid_t id, bool visible) {
+            get_node(id).set_visible(visible);
+            return *this;
+        }
+
+        /*!
+         * \brief Mark a whole branch for re-rendering
+         *
+         * \see Node::bump_revision
+         */
+        Node& HMITree::invalidate_subtree(nid_t id) {
+            Node& top = get_node(id);
+            std::unordered_set<const Node *> visited;
+            std::vector<Node *> pending(1, &top);
+
+            while (!pending.empty()) {
+                Node *node = pending.back();
+
+                pending.pop_back();
+                node->bump_revision();
+                for (Node *child : node->get_children())
+                    if (child->get_parents().size() < 2 || visited.insert(child).second)
+                        pending.push_back(child);
+            }
+            return top.mark_as_dirty();
+        }
+
+        /*!
+         * \brief Begin a transaction of updates
+         */
+        HMITree& HMITree::begin() {
+            if (in_transaction_)
+                throw HMIException(nullptr);
+            in_transaction_ = true;
+            return *this;
+        }
+
+        /*!
+         * \brief Check whether a transaction of updates has begun
+         */
+        bool HMITree::in_transaction() const noexcept {
+            return in_transaction_;
+        }
+
+        /*!
+         * \brief Stage an update of an existing tree node
+         *
+         * \details The node is looked up right away, so that an unknown id <!--
+         * --> is reported where it is staged.
+         */
+        HMITree& HMITree::stage_update(nid_t id, const std::vector<std::string>& parameters) {
+            if (!in_transaction_)
+                throw HMIException(nullptr);
+            get_node(id);
+            staged_updates_.push_back(std::make_pair(id, parameters));
+            return *this;
+        }
+
+        /*!
+         * \brief Commit a transaction of updates
+         *
+         * All staged nodes are resolved before any of them is updated. If
+         * one of them has been removed in the meantime, the transaction is
+         * left open and nothing is applied, i.e. the frame is never left
+         * with half of the transaction applied.
+         */
+        std::vector<nid_t> HMITree::commit() {
+            std::vector<nid_t> dirtied;
+            std::vector<Node *> nodes;
+
+            if (!in_transaction_)
+                throw HMIException(nullptr);
+            nodes.reserve(staged_updates_.size());
+            for (const auto& staged : staged_updates_)
+                nodes.push_back(&get_node(staged.first));
+
+            std::vector<std::pair<nid_t, std::vector<std::string>>> staged_updates;
+
+            staged_updates.swap(staged_updates_);
+            in_transaction_ = false;
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                bool was_dirty = nodes[i]->is_dirty();
+
+                nodes[i]->update(std::move(staged_updates[i].second));
+                if (!was_dirty && nodes[i]->is_dirty())
+                    dirtied.push_back(staged_updates[i].first);
+            }
+            return dirtied;
+        }
+
+        /*!
+         * \brief Register an existing branch as a named prototype
+         *
+         * The branch is traversed depth-first. Each node is copied once, as
+         * soon as it is discovered, and is assigned the index of its copy,
+         * through which the relations to its children are recorded.
+         */
+        HMITree& HMITree::register_prototype(const std::string& name, nid_t top_id) {
+            Prototype prototype;
+            std::unordered_map<const Node *, size_t> indices;
+            std::vector<const Node *> pending(1, &get_node(top_id));
+
+            indices.emplace(pending.back(), 0);
+            prototype.nodes.emplace_back(pending.back()->clone(top_id));
+            while (!pending.empty()) {
+                const Node *node = pending.back();
+                size_t index = indices.at(node);
+
+                pending.pop_back();
+                for (const Node *child : node->get_children()) {
+                    auto inserted = indices.emplace(child, prototype.nodes.size());
+
+                    if (inserted.second) {
+                        prototype.nodes.emplace_back(child->clone(child->get_id()));
+                        pending.push_back(child);
+                    }
+                    prototype.links.emplace_back(index, inserted.first->second);
+                }
+            }
+            prototypes_[name] = std::move(prototype);
+            return *this;
+        }
+
+        /*!
+         * \brief Check whether a prototype has been registered
+         */
+        bool HMITree::has_prototype(const std::string& name) const noexcept {
+            return prototypes_.find(name) != prototypes_.end();
+        }
+
+        /*!
+         * \brief Attach a new copy of a prototype to an existing tree node
+         */
+        nid_t HMITree::instantiate(const std::string& name, nid_t parent_id) {
+            return instantiate(name, get_node(parent_id));
+        }
+
+        /*!
+         * \brief Attach a new copy of a prototype to an existing tree node
+         *
+         * All nodes are cloned before any of them is linked. Should cloning
+         * fail, the clones are freed and their ids released, i.e. the tree
+         * is left unchanged.
+         *
+         * \details No input is parsed and no tree node is looked up, hence <!--
+         * --> instantiation takes time linear in the prototype's size.
+         */
+        nid_t HMITree::instantiate(const std::string& name, Node& parent) {
+            auto prototype_it = prototypes_.find(name);
+
+            if (prototype_it == prototypes_.end())
+                throw HMIException(nullptr);  // unknown prototype
+
+            const Prototype& prototype = prototype_it->second;
+            std::vector<Node *> nodes;
+
+            nodes.reserve(prototype.nodes.size());
+            try {
+                for (const auto& node : prototype.nodes)
+                    nodes.push_back(node->clone(lease_free_nid()));
+            } catch (...) {
+                for (Node *node : nodes) {
+                    release_nid(node->get_id());
+                    delete node;
+                }
+                throw;
+            }
+
+            for (const auto& link : prototype.links)
+                nodes[link.first]->add_child(nodes[link.second]);
+            parent.add_child(nodes.front()->mark_as_dirty());
+            for (Node *node : nodes)
+                index_[node->get_id()] = node;
+            return nodes.front()->get_id();
+        }
+
+        /*!
+         * \brief Find groups of structurally identical subtrees
+         *
+         * The groups (and the ids within each group) are sorted, so that the
+         * result does not depend on the order of the nodes' children.
+         */
+        std::vector<std::vector<nid_t>> HMITree::find_identical_subtrees() const {
+            std::unordered_map<const Node *, size_t> classes;
+            std::unordered_map<std::vector<size_t>, size_t, SubtreeKeyHash> canonical;
+            std::unordered_map<size_t, std::vector<nid_t>> members;
+            std::vector<std::vector<nid_t>> groups;
+
+            classify_branch(root_, classes, canonical);
+            for (const auto& entry : classes)
+                if (entry.first != &root_)
+                    members[entry.second].push_back(entry.first->get_id());
+            for (auto& entry : members) {
+                if (entry.second.size() < 2)
+                    continue;
+                std::sort(entry.second.begin(), entry.second.end());
+                groups.push_back(std::move(entry.second));
+            }
+            std::sort(groups.begin(), groups.end());
+            return groups;
+        }
+
         /*!
          * \brief Provide access to an existing tree node.
          *
+         * The node is looked up in the tree's index. Only nodes which have
+         * been linked directly (and are therefore not indexed) are searched
+         * for via BFS.
+         *
          * \see HMITree::bfs_iterator
          * \see HMITree::bfs_begin
          * \see HMITree::bfs_end
          */
         Node& HMITree::get_node(nid_t id) {
+            auto found = index_.find(id);
+
+            if (found != index_.end())
+                return *found->second;
             for (bfs_iterator it = bfs_begin(); it != bfs_end(); ++it) {
                 if (id == it->get_id()) {
                     it_container_.clear();
@@ -331,6 +896,21 @@ namespace hmi_tree_optimization {
 #pragma GCC diagnostic pop
         }
 
+        /*!
+         * \brief Index a new branch of the tree by its nodes' ids
+         */
+        void HMITree::index_branch(Node& top) {
+            std::vector<Node *> pending(1, &top);
+
+            while (!pending.empty()) {
+                Node *node = pending.back();
+
+                pending.pop_back();
+                if (index_.emplace(node->get_id(), node).second)  // shared branches are indexed once
+                    pending.insert(pending.end(), node->get_children().begin(), node->get_children().end());
+            }
+        }
+
         /*!
          * \brief Provide access to the root node of a tree.
          */
@@ -348,23 +928,75 @@ namespace hmi_tree_optimization {
         /*!
          * \brief Lease a free node id to address a tree's node.
          *
-         * \note A random sequence seed must be initialized before invoking <!--
-         * --> this function. Otherwise, the generated ids will be predictable.
+         * Released ids are kept on a stack. Since preferred ids may be leased
+         * whilst they are on it, taken ids are lazily skipped when popping
+         * the stack. The same applies to the never leased ids above the
+         * monotonic counter. Each id is skipped at most once per release,
+         * hence the amortized constant time.
+         *
+         * \details The occupancy bitmap grows up to the highest leased id, <!--
+         * --> unless that id lies far beyond it (e.g. an arbitrary id taken <!--
+         * --> from the input). Such outliers are kept in an ordered set <!--
+         * --> instead, so that a single huge id does not allocate a huge <!--
+         * --> bitmap. Once the bitmap catches up with the lowest outliers, <!--
+         * --> they are moved into it, each one once.
          */
-        nid_t HMITree::lease_free_nid(nid_t preferred_id) noexcept {
+        nid_t HMITree::lease_free_nid(nid_t preferred_id) {
             nid_t res;
 
-            if (id_pool_.find(preferred_id) == id_pool_.end()) {  // can lease prefered_id
+            if (!is_nid_leased(preferred_id)) {  // can lease preferred_id
                 res = preferred_id;
-            } else {  // generate a random node id
-                do
-                    res = rand() % std::numeric_limits<nid_t>::max() + 1;
-                while (id_pool_.find(res) != id_pool_.end());
+            } else {
+                while (!released_ids_.empty() && is_nid_leased(released_ids_.back()))
+                    released_ids_.pop_back();
+                if (!released_ids_.empty()) {  // reuse last released id
+                    res = released_ids_.back();
+                    released_ids_.pop_back();
+                } else {  // lease a never leased id
+                    while (is_nid_leased(next_nid_))
+                        ++next_nid_;
+                    res = next_nid_;
+                }
+            }
+            if (res >= leased_ids_.size() + max_dense_gap) {
+                sparse_leased_ids_.insert(res);
+                return res;
             }
-            id_pool_.insert(res);
+            if (res >= leased_ids_.size()) {
+                leased_ids_.resize(static_cast<size_t>(res) + 1, false);
+                // outliers which the bitmap has caught up with move into it
+                while (!sparse_leased_ids_.empty() && *sparse_leased_ids_.begin() < leased_ids_.size()) {
+                    leased_ids_[*sparse_leased_ids_.begin()] = true;
+                    sparse_leased_ids_.erase(sparse_leased_ids_.begin());
+                }
+            }
+            leased_ids_[res] = true;
             return res;
         }
 
+        /*!
+         * \brief Release a leased node id so that it may be leased again.
+         */
+        void HMITree::release_nid(nid_t id) noexcept {
+            if (!is_nid_leased(id))
+                return;
+            if (id < leased_ids_.size())
+                leased_ids_[id] = false;
+            else
+                sparse_leased_ids_.erase(id);
+            released_ids_.push_back(id);
+        }
+
+        /*!
+         * \brief Check whether a node id is leased.
+         */
+        bool HMITree::is_nid_leased(nid_t id) const noexcept {
+            if (id < leased_ids_.size())
+                return leased_ids_[id];
+            return !sparse_leased_ids_.empty()
+                && sparse_leased_ids_.find(id) != sparse_leased_ids_.end();
+        }
+
         /*!
          * \brief Begin DFS iteration. Get iterator to first element.
          *
@@ -374,6 +1006,7 @@ namespace hmi_tree_optimization {
          */
         dfs_iterator HMITree::dfs_begin() {
             it_container_.clear();
+            it_visited_.clear();
             return dfs_iterator(*this, &root_);
         }
 
@@ -395,6 +1028,7 @@ namespace hmi_tree_optimization {
          */
         bfs_iterator HMITree::bfs_begin() {
             it_container_.clear();
+            it_visited_.clear();
             return bfs_iterator(*this, &root_);
         }
 
@@ -416,7 +1050,9 @@ namespace hmi_tree_optimization {
          * \see src/tree/hmi_tree.cc
          */
         std::ostream& operator<<(std::ostream& out, const HMITree& hmi_tree) {
-            print_branch(hmi_tree.get_root(), out);
+            std::unordered_set<const Node *> printed;
+
+            print_branch(hmi_tree.get_root(), 0, printed, out);
             return out;
         }
     }  // namespace tree
@@ -0,0 +1,170 @@
+/*!
+ * \file src/tree/memory_pool.cc
+ * \brief Implementation of a size-class memory pool for tree objects
+ *
+ * \see include/tree/memory_pool.hh
+ *
+ * \author Petar Nikolov
+ * \version v1.0.0
+ */
+
+#include "tree/memory_pool.hh"
+
+#include <iostream>
+#include <new>
+#include <string>
+
+//! \namespace hmi_tree_optimization
+//! \brief Project namespace
+namespace hmi_tree_optimization {
+    //! \namespace tree
+    //! \brief Contains a bare bones simulated HMI tree
+    namespace tree {
+        constexpr size_t MemoryPool::granularity;  /*!< Size difference between two size classes. */
+        constexpr size_t MemoryPool::nsize_classes;  /*!< Number of size classes. */
+
+        /*!
+         * \brief Construct memory pool
+         *
+         * \details No memory is reserved until the first allocation.
+         */
+        MemoryPool::MemoryPool(const std::string& name, size_t nblocks_per_chunk)
+            : name_(name),
+              nblocks_per_chunk_(nblocks_per_chunk),
+              free_lists_(nsize_classes, nullptr),
+              nlive_blocks_(0),
+              noversized_(0),
+              nreserved_bytes_(0) {
+        }
+
+        /*!
+         * \brief Destroy memory pool and release all chunks
+         */
+        MemoryPool::~MemoryPool() noexcept {
+            for (void *chunk : chunks_)
+                ::operator delete(chunk);
+        }
+
+        /*!
+         * \brief Allocate a block of memory
+         *
+         * The block is popped from the free list of the request's size class.
+         * The pool grows by one chunk if that free list is empty.
+         *
+         * \see MemoryPool::grow
+         */
+        void *MemoryPool::allocate(size_t size) {
+            size_t sclass = size_class(size);
+            FreeBlock *block;
+
+            if (sclass == nsize_classes) {  // too large to be pooled
+                ++noversized_;
+                return ::operator new(size);
+            }
+            if (free_lists_[sclass] == nullptr)
+                grow(sclass);
+            block = free_lists_[sclass];
+            free_lists_[sclass] = block->next;
+            ++nlive_blocks_;
+            return block;
+        }
+
+        /*!
+         * \brief Return a block of memory to the pool
+         *
+         * The block is pushed onto the free list of its size class. It is
+         * not returned to the heap. Oversized blocks are returned to the heap
+         * directly, they are still counted as requests forwarded to it.
+         */
+        void MemoryPool::deallocate(void *ptr, size_t size) noexcept {
+            size_t sclass = size_class(size);
+            FreeBlock *block;
+
+            if (ptr == nullptr)
+                return;
+            if (sclass == nsize_classes) {
+                ::operator delete(ptr);
+                return;
+            }
+            block = static_cast<FreeBlock *>(ptr);
+            block->next = free_lists_[sclass];
+            free_lists_[sclass] = block;
+            --nlive_blocks_;
+        }
+
+        /*!
+         * \brief Get the number of chunks requested from the heap
+         */
+        size_t MemoryPool::nchunks() const noexcept {
+            return chunks_.size();
+        }
+
+        /*!
+         * \brief Get the number of blocks currently in use
+         */
+        size_t MemoryPool::nlive_blocks() const noexcept {
+            return nlive_blocks_;
+        }
+
+        /*!
+         * \brief Get the number of requests forwarded to the heap
+         */
+        size_t MemoryPool::noversized() const noexcept {
+            return noversized_;
+        }
+
+        /*!
+         * \brief Get the amount of memory reserved by the pool
+         */
+        size_t MemoryPool::nreserved_bytes() const noexcept {
+            return nreserved_bytes_;
+        }
+
+        /*!
+         * \brief Print the pool's statistics to an output stream.
+         */
+        MemoryPool& MemoryPool::print(std::ostream& out) noexcept {
+            out << "MemoryPool{"
+                << "name=" << name_
+                << ", chunks=" << chunks_.size()
+                << ", reserved=" << nreserved_bytes_
+                << ", live=" << nlive_blocks_
+                << ", oversized=" << noversized_
+                << "}" << std::endl;
+            return *this;
+        }
+
+        /*!
+         * \brief Find the size class of a requested size
+         *
+         * A size class 'c' holds blocks of '(c + 1) * granularity' bytes.
+         */
+        size_t MemoryPool::size_class(size_t size) noexcept {
+            size_t sclass = (size + granularity - 1) / granularity;
+
+            if (sclass == 0)
+                return 0;
+            return sclass > nsize_classes ? nsize_classes : sclass - 1;
+        }
+
+        /*!
+         * \brief Request a new chunk and split it into free blocks
+         *
+         * Each block in the chunk is linked to the next one. The first block
+         * becomes the head of the size class' free list.
+         */
+        void MemoryPool::grow(size_t sclass) {
+            size_t block_size = (sclass + 1) * granularity;
+            char *chunk = static_cast<char *>(::operator new(block_size * nblocks_per_chunk_));
+            FreeBlock *block;
+
+            chunks_.push_back(chunk);
+            nreserved_bytes_ += block_size * nblocks_per_chunk_;
+            for (size_t i = 0; i < nblocks_per_chunk_; ++i) {
+                block = reinterpret_cast<FreeBlock *>(chunk + i * block_size);
+                block->next = free_lists_[sclass];
+                free_lists_[sclass] = block;
+            }
+        }
+    }  // namespace tree
+}  // namespace hmi_tree_optimization
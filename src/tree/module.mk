@@ -9,6 +9,8 @@ TREE__INCLUDE := \
 	hmi_tree.hh \
 	node.hh \
 	hmi_exception.hh \
+	memory_pool.hh \
+	string_table.hh \
 	hmi_objects/hmi_view.hh \
 	hmi_objects/hmi_widget.hh \
 	hmi_objects/hmi_text.hh \
@@ -24,6 +26,8 @@ TREE__SRC := \
 	hmi_tree.cc \
 	node.cc \
 	hmi_exception.cc \
+	memory_pool.cc \
+	string_table.cc \
 	hmi_objects/hmi_view.cc \
 	hmi_objects/hmi_widget.cc \
 	hmi_objects/hmi_text.cc \
@@ -16,6 +16,8 @@
 #include <thread>
 #include <chrono>
 
+#include "tree/memory_pool.hh"
+
 //! \namespace hmi_tree_optimization
 //! \brief Project namespace
 namespace hmi_tree_optimization {
@@ -23,6 +25,7 @@ namespace hmi_tree_optimization {
     //! \brief Contains a bare bones simulated HMI tree
     namespace tree {
         constexpr long Node::render_time;  /*!< Average (simulated) time for rendering. */
+        size_t Node::visibility_epoch_ = 1;  /*!< Number of changes to any node's visibility or parents. */
 
         /*!
          * \brief Construct HMI tree node
@@ -30,7 +33,16 @@ namespace hmi_tree_optimization {
         Node::Node(nid_t id) noexcept 
             : id_(id),
               dirty_(false),
-              very_dirty_(false) {
+              dirty_descendants_(false),
+              very_dirty_(false),
+              visible_(true),
+              shown_(true),
+              shown_epoch_(0),
+              pending_update_(false),
+              dirty_by_update_(false),
+              revision_(0),
+              subtree_hash_(0),
+              subtree_hash_stale_(true) {
         }
 
         /*!
@@ -51,6 +63,38 @@ namespace hmi_tree_optimization {
             }
         }
 
+        /*!
+         * \brief Allocate memory for a node from the node pool
+         *
+         * Every HMI tree node type (HMIWidget, HMIText, etc.) which is created
+         * via 'new' is allocated from the node pool. Nodes of similar sizes
+         * share a size class and recycle each other's memory.
+         */
+        void *Node::operator new(size_t size) {
+            return pool().allocate(size);
+        }
+
+        /*!
+         * \brief Return a node's memory to the node pool
+         *
+         * \details Since the destructor is virtual, the provided size is <!--
+         * --> that of the node's dynamic type.
+         */
+        void Node::operator delete(void *ptr, size_t size) noexcept {
+            pool().deallocate(ptr, size);
+        }
+
+        /*!
+         * \brief Access the memory pool which serves all dynamically allocated nodes
+         *
+         * \details The pool is created on first use.
+         */
+        MemoryPool& Node::pool() {
+            static MemoryPool node_pool("nodes");
+
+            return node_pool;
+        }
+
         /*!
          * \brief Get the node's assigned id
          */
@@ -79,13 +123,21 @@ namespace hmi_tree_optimization {
          * opposite relation (i.e. associating this node as the given's parent)
          * is automatically accomplished if it hasn't been done already.
          *
+         * If the new child (or any of its descendants) is dirty, this node and
+         * all of its parents are marked as having dirty descendants.
+         *
          * \see Node::add_parent
          * \see Node::has_parent
          */
         Node& Node::add_child(Node *child_node) {
-            children_.insert(child_node);
+            if (children_.insert(child_node).second)
+                invalidate_subtree_hash();
             if (!child_node->has_parent(this))
                 child_node->add_parent(this);
+            if ((child_node->dirty_ || child_node->dirty_descendants_) && !dirty_descendants_) {
+                dirty_descendants_ = true;
+                propagate_dirtiness();
+            }
             return *this;
         }
 
@@ -107,7 +159,8 @@ namespace hmi_tree_optimization {
          * \see Node::has_parent
          */
         Node& Node::remove_child(Node *child_node) {
-            children_.erase(child_node);
+            if (children_.erase(child_node))
+                invalidate_subtree_hash();
             if (child_node->has_parent(this))
                 child_node->remove_parent(this);
             return *this;
@@ -161,7 +214,8 @@ namespace hmi_tree_optimization {
          * \see Node::has_child
          */
         Node& Node::add_parent(Node *parent_node) {
-            parents_.insert(parent_node);
+            if (parents_.insert(parent_node).second)
+                ++visibility_epoch_;  // the branch may be shown via its new parent
             if (!parent_node->has_child(this))
                 parent_node->add_child(this);
             return *this;
@@ -185,7 +239,8 @@ namespace hmi_tree_optimization {
          * \see Node::has_child
          */
         Node& Node::remove_parent(Node *parent_node) {
-            parents_.erase(parent_node);
+            if (parents_.erase(parent_node))
+                ++visibility_epoch_;  // the branch may no longer be shown
             if (parent_node->has_child(this))
                 parent_node->remove_child(this);
             return *this;
@@ -224,6 +279,67 @@ namespace hmi_tree_optimization {
             return dirty_;
         }
 
+        /*!
+         * \brief Check if any (direct or indirect) child node is dirty
+         */
+        bool Node::has_dirty_descendants() const noexcept {
+            return dirty_descendants_;
+        }
+
+        /*!
+         * \brief Check if node is visible
+         */
+        bool Node::is_visible() const noexcept {
+            return visible_;
+        }
+
+        /*!
+         * \brief Check if node is shown on the screen
+         *
+         * Recursively checks the node's parents until a shown one is found.
+         * The result is cached until any node's visibility or parents
+         * change, hence each ancestor is checked at most once in between,
+         * even if it is reachable via many paths.
+         */
+        bool Node::is_shown() const noexcept {
+            if (shown_epoch_ == visibility_epoch_)
+                return shown_;
+            shown_ = visible_ && (parents_.empty()
+                    || std::any_of(parents_.begin(), parents_.end(), [](const Node *parent) {
+                        return parent->is_shown();
+                        }));
+            shown_epoch_ = visibility_epoch_;
+            return shown_;
+        }
+
+        /*!
+         * \brief Get the current visibility epoch
+         */
+        size_t Node::get_visibility_epoch() noexcept {
+            return visibility_epoch_;
+        }
+
+        /*!
+         * \brief Show or hide this node (alongside its branch)
+         *
+         * \details The node's own flag is toggled in constant time. Marking <!--
+         * --> the parents stops at already marked ones.
+         */
+        Node& Node::set_visible(bool visible) noexcept {
+            if (visible_ == visible)
+                return *this;
+            visible_ = visible;
+            ++visibility_epoch_;  // the branch's cached effective visibility is stale
+            for (const Node *parent : parents_) {
+                parent->invalidate_subtree_hash();
+                if (!parent->dirty_descendants_) {
+                    parent->dirty_descendants_ = true;
+                    parent->propagate_dirtiness();
+                }
+            }
+            return *this;
+        }
+
         /*!
          * \brief Check if node is very dirty
          *
@@ -268,22 +384,126 @@ namespace hmi_tree_optimization {
          */
         Node& Node::clean_up() noexcept {
             dirty_ = false;
+            dirty_by_update_ = false;
+            dirty_descendants_ = false;
             return *this;
         }
 
         /*!
          * \brief Update this node
          *
-         * After applying the requested update, the node is marked as dirty.
+         * The requested update replaces any pending one and the node is
+         * marked as dirty. If it equals the pending update or (when there is
+         * none) it would not change the node, it is ignored. All of its
+         * (direct and indirect) parents are marked as having dirty
+         * descendants.
          *
-         * \see Node::apply_update
+         * \details The pending buffer is assigned in place, i.e. its <!--
+         * --> strings' memory is reused.
          */
         Node& Node::update(const std::vector<std::string>& parameters) {
-            apply_update(parameters);
+            if (pending_update_ ? parameters == pending_parameters_ : !would_change(parameters))
+                return *this;
+            pending_parameters_ = parameters;
+            pending_update_ = true;
+            dirty_by_update_ = !dirty_ || dirty_by_update_;
             dirty_ = true;
+            propagate_dirtiness();
             return *this;
         }
 
+        /*!
+         * \brief Update this node
+         */
+        Node& Node::update(std::vector<std::string>&& parameters) {
+            if (pending_update_ ? parameters == pending_parameters_ : !would_change(parameters))
+                return *this;
+            pending_parameters_.swap(parameters);
+            pending_update_ = true;
+            dirty_by_update_ = !dirty_ || dirty_by_update_;
+            dirty_ = true;
+            propagate_dirtiness();
+            return *this;
+        }
+
+        /*!
+         * \brief Check whether an update would change the node's visible state
+         */
+        bool Node::would_change(const std::vector<std::string>& parameters) const {
+            return is_changed_by(parameters);
+        }
+
+        /*!
+         * \brief Check if node has a pending update
+         */
+        bool Node::has_pending_update() const noexcept {
+            return pending_update_;
+        }
+
+        /*!
+         * \brief Apply the newest pending update (if there is one)
+         *
+         * The pending update is compared against the node's current
+         * (committed) state first. If it would not change the node (e.g. a
+         * value which has been changed and changed back within one frame),
+         * it is dropped and the node is no longer dirty, unless it has been
+         * marked as dirty for another reason.
+         *
+         * \see Node::apply_update
+         */
+        Node& Node::apply_pending_update() {
+            if (!pending_update_)
+                return *this;
+            pending_update_ = false;
+            if (!would_change(pending_parameters_)) {  // update has been reverted
+                if (dirty_by_update_)
+                    dirty_ = dirty_by_update_ = false;
+                return *this;
+            }
+            apply_update(pending_parameters_);
+            invalidate_subtree_hash();
+            return *this;
+        }
+
+        /*!
+         * \brief Mark this node as dirty without updating it
+         */
+        Node& Node::mark_as_dirty() noexcept {
+            ++revision_;  // the branch's cached state must not be reused
+            invalidate_subtree_hash();
+            dirty_ = true;
+            dirty_by_update_ = false;
+            propagate_dirtiness();
+            return *this;
+        }
+
+        /*!
+         * \brief Invalidate any cached state of this node without marking it as dirty
+         */
+        Node& Node::bump_revision() noexcept {
+            ++revision_;
+            invalidate_subtree_hash();
+            return *this;
+        }
+
+        /*!
+         * \brief Create a detached copy of this node
+         *
+         * A pending update is copied as well, so that the copy catches up
+         * with this node once it is applied.
+         *
+         * \see Node::clone_node
+         */
+        Node *Node::clone(nid_t id) const {
+            Node *copy = clone_node(id);
+
+            if (pending_update_) {
+                copy->pending_parameters_ = pending_parameters_;
+                copy->pending_update_ = true;
+            }
+            return copy;
+        }
+
         /*!
          * \brief Simulate time-consuming work when rendering a node
          *
@@ -300,6 +520,8 @@ namespace hmi_tree_optimization {
         /*!
          * \brief Cache this node and return an entry to be stored
          *
+         * The entry records the node's current subtree hash.
+         *
          * \details The CacheEntry instance is to be dynamically allocated. <!--
          * --> The caller is responsible for freeing the allocated memory.
          *
@@ -310,7 +532,11 @@ namespace hmi_tree_optimization {
         CacheEntry *Node::cache(bool debug, std::ostream& out) {
             if (debug)
                 out << "Caching node " << id_ << "..." << std::endl;
-            return generate_cache_entry();
+
+            CacheEntry *entry = generate_cache_entry();
+
+            entry->set_source_hash(subtree_hash());
+            return entry;
         }
 
         /*!
@@ -327,6 +553,60 @@ namespace hmi_tree_optimization {
             return *this;
         }
 
+        /*!
+         * \brief Overwrite an existing cache entry with this node's current state
+         *
+         * The entry records the node's current subtree hash.
+         *
+         * \see CacheEntry
+         * \see Node::update_cache_entry
+         * \see Node::cache
+         */
+        Node& Node::recache(CacheEntry& entry, bool debug, std::ostream& out) {
+            if (debug)
+                out << "Re-caching node " << id_ << "..." << std::endl;
+            update_cache_entry(entry);
+            entry.set_source_hash(subtree_hash());
+            return *this;
+        }
+
+        /*!
+         * \brief Hash the node's own content (excluding its children)
+         *
+         * \see Node::hash_content
+         */
+        size_t Node::content_hash() const noexcept {
+            return hash_content();
+        }
+
+        /*!
+         * \brief Hash the node's whole branch (Merkle hash)
+         *
+         * \details The children's hashes are mixed and summed up, hence <!--
+         * --> their order does not matter.
+         */
+        size_t Node::subtree_hash() const noexcept {
+            if (!subtree_hash_stale_)
+                return subtree_hash_;
+
+            size_t children_hash = 0;
+            size_t hash = static_cast<size_t>(to_letter());
+
+            for (const Node *child : children_) {
+                if (!child->visible_)
+                    continue;  // hidden children do not affect the branch's appearance
+
+                size_t child_hash = child->subtree_hash();
+
+                children_hash += child_hash ^ (child_hash >> 29) ^ 0x9e3779b97f4a7c15;
+            }
+            for (size_t value : {content_hash(), revision_, children_hash})
+                hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+            subtree_hash_ = hash;
+            subtree_hash_stale_ = false;
+            return subtree_hash_;
+        }
+
         /*!
          * \brief Count the number of all direct and indirect children
          *
@@ -353,6 +633,37 @@ namespace hmi_tree_optimization {
             return count;
         }
 
+        /*!
+         * \brief Mark all (direct and indirect) parents as having dirty descendants
+         *
+         * Every path upwards is followed, so that a branch which is referenced
+         * by several parents makes each one of them aware of its dirtiness.
+         */
+        void Node::propagate_dirtiness() const noexcept {
+            if (!visible_)
+                return;  // changes to hidden branches are not seen
+            for (const Node *parent : parents_) {
+                if (!parent->dirty_descendants_) {
+                    parent->dirty_descendants_ = true;
+                    parent->propagate_dirtiness();
+                }
+            }
+        }
+
+        /*!
+         * \brief Mark the subtree hashes of this node and of all its ancestors as stale
+         *
+         * \details Unlike the dirtiness, staleness is propagated through <!--
+         * --> hidden nodes as well, since it describes the branch's state.
+         */
+        void Node::invalidate_subtree_hash() const noexcept {
+            if (subtree_hash_stale_)
+                return;
+            subtree_hash_stale_ = true;
+            for (const Node *parent : parents_)
+                parent->invalidate_subtree_hash();
+        }
+
         /*!
          * \brief Print a node to an output stream
          *
@@ -0,0 +1,104 @@
+/*!
+ * \file src/tree/string_table.cc
+ * \brief Implementation of a table of interned strings
+ *
+ * \see include/tree/string_table.hh
+ *
+ * \author Petar Nikolov
+ * \version v1.0.0
+ */
+
+#include "tree/string_table.hh"
+
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//! \namespace hmi_tree_optimization
+//! \brief Project namespace
+namespace hmi_tree_optimization {
+    //! \namespace tree
+    //! \brief Contains a bare bones simulated HMI tree
+    namespace tree {
+        /*!
+         * \brief Construct string table
+         */
+        StringTable::StringTable() {
+            intern("");
+        }
+
+        /*!
+         * \brief Intern a string
+         *
+         * If the string has not been interned so far, it is copied into the
+         * table and assigned the id of a removed string or, if there is none,
+         * the next available one.
+         *
+         * \details The table's elements are nodes of a hash map which are <!--
+         * --> never moved. Therefore, the pointers to them stay valid.
+         */
+        sid_t StringTable::intern(const std::string& s) {
+            auto it = ids_.find(s);
+
+            if (it == ids_.end()) {
+                sid_t id = static_cast<sid_t>(strings_.size());
+
+                if (!free_ids_.empty())
+                    id = free_ids_.back();
+                it = ids_.insert(std::make_pair(s, id)).first;
+                if (id == strings_.size()) {
+                    strings_.push_back(&it->first);
+                    refs_.push_back(0);
+                } else {
+                    free_ids_.pop_back();
+                    strings_[id] = &it->first;
+                }
+            }
+            ++refs_[it->second];
+            return it->second;
+        }
+
+        /*!
+         * \brief Acquire another reference to an interned string
+         */
+        void StringTable::retain(sid_t id) noexcept {
+            ++refs_[id];
+        }
+
+        /*!
+         * \brief Give back a reference to an interned string
+         *
+         * \details The removed string's id is kept for reuse, i.e. the ids <!--
+         * --> stay dense.
+         */
+        void StringTable::release(sid_t id) {
+            if (--refs_[id] > 0 || id == 0)
+                return;
+            ids_.erase(*strings_[id]);
+            strings_[id] = nullptr;
+            free_ids_.push_back(id);
+        }
+
+        /*!
+         * \brief Get an interned string
+         *
+         * \note If the id is unknown or its string has been removed, a <!--
+         * --> std::out_of_range exception is thrown.
+         */
+        const std::string& StringTable::lookup(sid_t id) const {
+            const std::string *s = strings_.at(id);
+
+            if (s == nullptr)
+                throw std::out_of_range("removed string id");
+            return *s;
+        }
+
+        /*!
+         * \brief Get the number of interned strings
+         */
+        size_t StringTable::size() const noexcept {
+            return ids_.size();
+        }
+    }  // namespace tree
+}  // namespace hmi_tree_optimization
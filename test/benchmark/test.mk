@@ -0,0 +1,40 @@
+# C++ source files of 'benchmark' module's tests.
+# They are prepended their module's relative path to the main Makefile.
+BENCHMARK__TEST_SRC :=
+BENCHMARK__TEST_SRC := $(patsubst %,$(TEST)/$(BENCHMARK__MODULE_NAME)/%,$(BENCHMARK__TEST_SRC))
+
+# Object files of 'benchmark' module's tests.
+BENCHMARK__TEST_OBJ := $(patsubst $(TEST)/%.cc,$(TEST_OBJ)/%.o,$(BENCHMARK__TEST_SRC))
+
+# Create required subdirectories for module's tests' object files
+BENCHMARK__TEST_OBJ_DIRS := $(subst $(TEST),$(TEST_OBJ),$(shell find $(TEST)/$(BENCHMARK__MODULE_NAME)/ -type d))
+$(foreach obj_dir,$(BENCHMARK__TEST_OBJ_DIRS),$(shell mkdir -p $(obj_dir)))
+# Create required subdirectories for module's tests' binaries
+BENCHMARK__TEST_BIN_DIRS := $(subst $(TEST),$(TEST_OUT),$(shell find $(TEST)/$(BENCHMARK__MODULE_NAME)/ -type d))
+$(foreach bin_dir,$(BENCHMARK__TEST_BIN_DIRS),$(shell mkdir -p $(bin_dir)))
+
+# Include module's tests as dependencies of the 'test' target.
+ALL_TEST_TARGETS += benchmark_test
+
+.PHONY: benchmark_test
+
+# Make target for all of 'benchmark' module's tests.
+benchmark_test: $(TEST_CONFIG_OBJ) $(TEST_MODULE_OBJ) $(BENCHMARK__TEST_OBJ) \
+		$(BENCHMARK__OBJ) $(HELPER_OBJ)
+	@# Create temporary directory for tests' binaries.
+	mkdir -p $(TEST_OUT)/$(BENCHMARK__MODULE_NAME)
+	@# Compile each test file into its own test binary.
+	$(foreach obj, \
+			  $(BENCHMARK__TEST_OBJ), \
+			  $(CXX) $(CXXFLAGS) -o $(patsubst $(TEST_OBJ)/%.o,$(TEST_OUT)/%,$(obj)) \
+			  $(TEST_CONFIG_OBJ) $(TEST_MODULE_OBJ) \
+			  $(obj) $(BENCHMARK__OBJ) $(HELPER_OBJ) $(LIBS)$(NEWLINE))
+	@echo $(LOG_STAMP): $(BENCHMARK__MODULE_NAME) tests compilation successful.
+
+# Make target for 'benchmark' module's tests' object files.
+$(TEST_OBJ)/$(BENCHMARK__MODULE_NAME)/%_test.o: $(TEST)/$(BENCHMARK__MODULE_NAME)/%_test.cc \
+		$(SRC)/$(BENCHMARK__MODULE_NAME)/%.cc
+	@# Create temporary directory for tests' object files.
+	@mkdir -p $(TEST_OBJ)/$(BENCHMARK__MODULE_NAME)
+	$(CXX) $(CXXFLAGS) -o $@ -c $<
+
@@ -3,6 +3,9 @@
 // Force Catch to use cpp11's 'std::to_string'
 // instead of 'std::stringstream' workaround.
 #define CATCH_CONFIG_CPP11_TO_STRING
+// Newer glibc versions no longer define 'SIGSTKSZ' as a constant,
+// which Catch's POSIX signal handler requires.
+#define CATCH_CONFIG_NO_POSIX_SIGNALS
 
 #include "catch2/catch.hpp"
 
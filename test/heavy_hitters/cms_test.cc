@@ -0,0 +1,51 @@
+#include "catch2/catch.hpp"
+
+#include <stdexcept>
+
+#include "heavy_hitters/cms.hh"
+#include "heavy_hitters/cms_shards.hh"
+
+using namespace hmi_tree_optimization::heavy_hitters;
+
+TEST_CASE("Merged shards count like a single sketch", "[cms]") {
+    constexpr unsigned nelements = 1000;
+    CMS<unsigned> single(10, 0.01);
+    CMS<unsigned> global = single.shard();
+    CMSShards<unsigned> shards(global, 4);
+
+    for (unsigned i = 0; i < nelements; ++i) {
+        unsigned x = i % 37;
+        size_t weight = 1 + i % 3;
+
+        single.increment(x, weight);
+        shards.shard(i % shards.size()).increment(x, weight);
+    }
+    REQUIRE(global.mass() == 0);
+    shards.merge();
+    REQUIRE(global.mass() == single.mass());
+    for (unsigned x = 0; x < 50; ++x)
+        REQUIRE(global.count(x) == single.count(x));
+    for (size_t i = 0; i < shards.size(); ++i)
+        REQUIRE(shards.shard(i).mass() == 0);
+}
+
+TEST_CASE("Merging is additive", "[cms]") {
+    CMS<unsigned> sketch(10, 0.01);
+    CMS<unsigned> shard = sketch.shard();
+
+    sketch.increment(7, 2);
+    shard.increment(7, 3).increment(8);
+    sketch.merge(shard);
+    REQUIRE(sketch.mass() == 6);
+    REQUIRE(sketch.count(7) >= 5);
+    REQUIRE(sketch.count(8) >= 1);
+    REQUIRE(shard.mass() == 4);  // the merged sketch is left unchanged
+}
+
+TEST_CASE("Sketches with different hash functions cannot be merged", "[cms]") {
+    CMS<unsigned> sketch(10, 0.01);
+    CMS<unsigned> other(20, 0.01);
+
+    REQUIRE_THROWS_AS(sketch.merge(other), std::invalid_argument);
+    REQUIRE(sketch.mass() == 0);
+}
@@ -1,6 +1,6 @@
 # C++ source files of 'heavy_hitters' module's tests.
 # They are prepended their module's relative path to the main Makefile.
-HEAVY_HITTERS__TEST_SRC :=
+HEAVY_HITTERS__TEST_SRC := cms_test.cc
 HEAVY_HITTERS__TEST_SRC := $(patsubst %,$(TEST)/$(HEAVY_HITTERS__MODULE_NAME)/%,$(HEAVY_HITTERS__TEST_SRC))
 
 # Object files of 'heavy_hitters' module's tests.
@@ -28,7 +28,7 @@ heavy_hitters_test: $(TEST_CONFIG_OBJ) $(TEST_MODULE_OBJ) $(HEAVY_HITTERS__TEST_
 			  $(HEAVY_HITTERS__TEST_OBJ), \
 			  $(CXX) $(CXXFLAGS) -o $(patsubst $(TEST_OBJ)/%.o,$(TEST_OUT)/%,$(obj)) \
 			  $(TEST_CONFIG_OBJ) $(TEST_MODULE_OBJ) \
-			  $(obj) $(HEAVY_HITTERS__OBJ) $(HELPER_OBJ) $(LIBS)$(NEWLINE))
+			  $(obj) $(sort $(HEAVY_HITTERS__OBJ) $(HELPER_OBJ)) $(LIBS)$(NEWLINE))
 	@echo $(LOG_STAMP): $(HEAVY_HITTERS__MODULE_NAME) tests compilation successful.
 
 # Make target for 'heavy_hitters' module's tests' object files.
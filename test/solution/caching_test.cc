@@ -0,0 +1,179 @@
+#include "catch2/catch.hpp"
+
+#include <memory>
+#include <vector>
+
+#include "heavy_hitters/cms.hh"
+#include "solution/caching.hh"
+#include "solution/config.hh"
+#include "tree/cache_entry.hh"
+#include "tree/cache_entries/hmi_widget_cache_entry.hh"
+#include "tree/hmi_tree.hh"
+#include "tree/node.hh"
+
+using namespace hmi_tree_optimization::solution;
+using namespace hmi_tree_optimization::tree;
+
+namespace {
+    /*!
+     * \brief Build a tree of three pages, each holding a text node.
+     *
+     * \return Node records of the tree (pages 1, 3 and 5).
+     */
+    std::vector<NodeRecord> page_records() {
+        return {
+            NodeRecord{0, 'W', 1, {}},
+            NodeRecord{1, 'T', 2, {"a"}},
+            NodeRecord{0, 'W', 3, {}},
+            NodeRecord{3, 'T', 4, {"b"}},
+            NodeRecord{0, 'W', 5, {}},
+            NodeRecord{5, 'T', 6, {"c"}}
+        };
+    }
+}  // anonymous namespace
+
+TEST_CASE("The first page switch hides every other page", "[caching][pages]") {
+    HMITree tree;
+
+    clear_cache();
+    tree.build(page_records());
+    switch_page(tree, 3);
+    REQUIRE(tree.get_node(3).is_visible());
+    REQUIRE_FALSE(tree.get_node(1).is_visible());
+    REQUIRE_FALSE(tree.get_node(5).is_visible());
+    switch_page(tree, 5);
+    REQUIRE(tree.get_node(5).is_visible());
+    REQUIRE_FALSE(tree.get_node(3).is_visible());
+    REQUIRE_FALSE(tree.get_node(1).is_visible());
+    clear_cache();
+}
+
+TEST_CASE("Hidden pages stay cached by default", "[caching][pages]") {
+    HMITree tree;
+    DirtinessScore score = [](nid_t) { return 0.0; };
+
+    clear_cache();
+    tree.build(page_records());
+    switch_page(tree, 1);
+    evaluate_tree_dirtiness(tree, score, 1.0);
+    refresh_screen(tree);
+    REQUIRE(g_cache_table.count(1) == 1);
+    switch_page(tree, 3);
+    evaluate_tree_dirtiness(tree, score, 1.0);
+    refresh_screen(tree);
+    REQUIRE(g_cache_table.count(1) == 1);  // warm
+    REQUIRE(g_cache_table.count(3) == 1);
+    clear_cache();
+}
+
+TEST_CASE("Versions are kept once per branch and taken by their source hash", "[caching][versions]") {
+    const size_t cache_versions = g_cache_versions;
+    auto entry = [](size_t source_hash) {
+        std::shared_ptr<CacheEntry> res(new HMIWidgetCacheEntry());
+
+        res->set_source_hash(source_hash);
+        return res;
+    };
+    std::shared_ptr<CacheEntry> first = entry(1);
+    std::shared_ptr<CacheEntry> second = entry(2);
+
+    clear_cache();
+
+    SECTION("Disabled versions") {
+        g_cache_versions = 1;
+        stash_version(7, first);
+        REQUIRE(take_version(7, 1) == nullptr);
+    }
+
+    SECTION("Duplicate versions") {
+        g_cache_versions = 3;  // two versions besides the cached entry
+        stash_version(7, first);
+        stash_version(7, second);
+        stash_version(7, entry(1));  // same branch as the first one
+        REQUIRE(take_version(7, 1) == first);
+        REQUIRE(take_version(7, 1) == nullptr);  // taken
+        REQUIRE(take_version(7, 2) == second);
+        REQUIRE(take_version(8, 2) == nullptr);  // other node
+    }
+
+    SECTION("Least recently used versions") {
+        g_cache_versions = 3;
+        stash_version(7, first);
+        stash_version(7, second);
+        stash_version(7, entry(1));  // the first version becomes the most recent one
+        stash_version(7, entry(3));
+        REQUIRE(take_version(7, 2) == nullptr);  // evicted
+        REQUIRE(take_version(7, 1) == first);
+        REQUIRE(take_version(7, 3) != nullptr);
+    }
+    g_cache_versions = cache_versions;
+    clear_cache();
+}
+
+TEST_CASE("Weighted counts make expensive branches heavy hitters first", "[caching][weights]") {
+    const bool weighted_counts = g_weighted_counts;
+    const size_t k = 2;
+    HMITree tree;
+    std::vector<NodeRecord> records(1, NodeRecord{0, 'W', 1, {}});
+    auto heavy_hitters = [k]() {
+        hmi_tree_optimization::heavy_hitters::CMS<nid_t> cms(k, 0.01);
+        std::vector<nid_t> res;
+
+        // the widget's branch is updated once, the lone text thrice
+        for (nid_t id : {1, 20, 20, 20})
+            cms.increment(id, occurrence_weight(id));
+        for (nid_t id : {1, 20})
+            if (cms.count(id) >= static_cast<double>(cms.mass()) / k)
+                res.push_back(id);
+        return res;
+    };
+
+    clear_cache();
+    for (nid_t id = 2; id < 10; ++id)
+        records.push_back(NodeRecord{1, 'T', id, {"row"}});
+    records.push_back(NodeRecord{0, 'T', 20, {"lone"}});
+    tree.build(records);
+    evaluate_tree_dirtiness(tree, [](nid_t) { return 0.0; }, 1.0);
+    REQUIRE(branch_cost(1) == 9.0);
+
+    g_weighted_counts = false;
+    REQUIRE(occurrence_weight(1) == 1);
+    REQUIRE(heavy_hitters() == std::vector<nid_t>{20});
+    g_weighted_counts = true;
+    REQUIRE(occurrence_weight(1) == 9);
+    REQUIRE(occurrence_weight(20) == 1);
+    REQUIRE(heavy_hitters() == std::vector<nid_t>{1});
+    g_weighted_counts = weighted_counts;
+    clear_cache();
+}
+
+TEST_CASE("Identical subtrees share an entry until one of them is updated", "[caching][dedup]") {
+    HMITree tree;
+    DirtinessScore score = [](nid_t) { return 0.0; };
+    auto refresh = [&tree, &score]() {
+        evaluate_tree_dirtiness(tree, score, 1.0);
+        refresh_screen(tree);
+    };
+
+    clear_cache();
+    tree.build({
+        NodeRecord{0, 'W', 1, {}},
+        NodeRecord{1, 'T', 2, {"row"}},
+        NodeRecord{0, 'W', 3, {}},
+        NodeRecord{3, 'T', 4, {"row"}}
+    });
+    refresh();
+    REQUIRE(g_cache_table.at(1) != g_cache_table.at(3));
+    REQUIRE(share_identical_subtrees(tree) == 2);  // rows and texts
+    REQUIRE(g_cache_table.at(1) == g_cache_table.at(3));
+    refresh();
+    REQUIRE(g_cache_table.at(1) == g_cache_table.at(3));
+
+    const std::shared_ptr<CacheEntry> shared = g_cache_table.at(3);
+
+    tree.get_node(2).update({"edited"}).apply_pending_update();
+    refresh();
+    REQUIRE(g_cache_table.at(1) != shared);  // copy-on-write
+    REQUIRE(g_cache_table.at(3) == shared);
+    clear_cache();
+}
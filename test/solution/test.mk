@@ -1,6 +1,6 @@
 # C++ source files of 'solution' module's tests.
 # They are prepended their module's relative path to the main Makefile.
-SOLUTION__TEST_SRC :=
+SOLUTION__TEST_SRC := caching_test.cc
 SOLUTION__TEST_SRC := $(patsubst %,$(TEST)/$(SOLUTION__MODULE_NAME)/%,$(SOLUTION__TEST_SRC))
 
 # Object files of 'solution' module's tests.
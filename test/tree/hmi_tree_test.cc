@@ -0,0 +1,232 @@
+#include "catch2/catch.hpp"
+
+#include <string>
+#include <vector>
+
+#include "tree/hmi_tree.hh"
+#include "tree/hmi_exception.hh"
+#include "tree/node.hh"
+#include "tree/hmi_objects/hmi_widget.hh"
+
+using namespace hmi_tree_optimization::tree;
+
+namespace {
+    /*!
+     * \brief Build a tree of two widgets, each holding a text node.
+     *
+     * \return Node records of the tree (ids 1 to 4).
+     */
+    std::vector<NodeRecord> widget_records() {
+        return {
+            NodeRecord{0, 'W', 1, {}},
+            NodeRecord{1, 'T', 2, {"a"}},
+            NodeRecord{0, 'W', 3, {}},
+            NodeRecord{3, 'T', 4, {"b"}}
+        };
+    }
+}  // anonymous namespace
+
+TEST_CASE("Released node ids are leased again, most recent first", "[hmi_tree][ids]") {
+    HMITree tree;
+    nid_t first = tree.lease_free_nid();
+    nid_t second = tree.lease_free_nid();
+
+    REQUIRE(tree.is_nid_leased(0));  // root
+    REQUIRE(first != second);
+    tree.release_nid(first);
+    tree.release_nid(second);
+    REQUIRE_FALSE(tree.is_nid_leased(first));
+    REQUIRE(tree.lease_free_nid() == second);
+    REQUIRE(tree.lease_free_nid() == first);
+    REQUIRE(tree.lease_free_nid() == second + 1);
+}
+
+TEST_CASE("A preferred node id is leased unless it is taken", "[hmi_tree][ids]") {
+    HMITree tree;
+
+    REQUIRE(tree.lease_free_nid(42) == 42);
+    REQUIRE(tree.is_nid_leased(42));
+    REQUIRE(tree.lease_free_nid(42) != 42);
+    tree.release_nid(42);
+    tree.release_nid(42);  // releasing twice has no effect
+    REQUIRE_FALSE(tree.is_nid_leased(42));
+}
+
+TEST_CASE("Outlier node ids do not affect the dense ids", "[hmi_tree][ids]") {
+    HMITree tree;
+    const nid_t outlier = 4000000000u;
+
+    REQUIRE(tree.lease_free_nid(outlier) == outlier);
+    REQUIRE(tree.is_nid_leased(outlier));
+    REQUIRE_FALSE(tree.is_nid_leased(outlier - 1));
+    REQUIRE(tree.lease_free_nid() == 1);
+    tree.release_nid(outlier);
+    REQUIRE_FALSE(tree.is_nid_leased(outlier));
+    REQUIRE(tree.lease_free_nid(outlier) == outlier);
+}
+
+TEST_CASE("Outlier node ids move into the bitmap once it catches up", "[hmi_tree][ids]") {
+    HMITree tree;
+    const nid_t outlier = 70000;
+
+    REQUIRE(tree.lease_free_nid(outlier) == outlier);
+    REQUIRE(tree.lease_free_nid(60000) == 60000);  // bitmap grows up to 60000
+    REQUIRE(tree.lease_free_nid(outlier + 1) == outlier + 1);  // ... and beyond the outlier
+    REQUIRE(tree.is_nid_leased(outlier));
+    REQUIRE_FALSE(tree.is_nid_leased(outlier - 1));
+    tree.release_nid(outlier);
+    REQUIRE_FALSE(tree.is_nid_leased(outlier));
+    REQUIRE(tree.lease_free_nid() == outlier);
+}
+
+TEST_CASE("Leased node ids are not taken by new nodes", "[hmi_tree][ids]") {
+    HMITree tree;
+    nid_t leased = tree.lease_free_nid(7);
+
+    REQUIRE_THROWS_AS(tree.build({NodeRecord{0, 'W', leased, {}}}), HMIException);
+    REQUIRE_THROWS_AS(tree.apply_patch({
+        PatchOperation{PatchOperation::Kind::add, NodeRecord{0, 'W', leased, {}}}
+    }), HMIException);
+    REQUIRE(tree.get_root().get_children().empty());
+    REQUIRE(tree.is_nid_leased(leased));
+}
+
+TEST_CASE("Invalid patch operations throw and keep the preceding ones", "[hmi_tree][patch]") {
+    HMITree tree;
+
+    tree.build(widget_records());
+
+    SECTION("Unknown node") {
+        std::vector<PatchOperation> patch = {
+            PatchOperation{PatchOperation::Kind::remove, NodeRecord{0, 'W', 3, {}}},
+            PatchOperation{PatchOperation::Kind::remove, NodeRecord{0, 'W', 99, {}}}
+        };
+
+        REQUIRE_THROWS_AS(tree.apply_patch(patch), HMIException);
+        REQUIRE_THROWS_AS(tree.get_node(3), HMIException);
+        REQUIRE_FALSE(tree.is_nid_leased(3));
+        REQUIRE(tree.get_node(1).get_id() == 1);
+    }
+
+    SECTION("Taken id") {
+        std::vector<PatchOperation> patch = {
+            PatchOperation{PatchOperation::Kind::add, NodeRecord{1, 'T', 5, {"c"}}},
+            PatchOperation{PatchOperation::Kind::add, NodeRecord{1, 'T', 2, {"d"}}}
+        };
+
+        REQUIRE_THROWS_AS(tree.apply_patch(patch), HMIException);
+        REQUIRE(tree.get_node(5).get_id() == 5);
+        REQUIRE(tree.get_node(1).get_children().size() == 2);
+    }
+
+    SECTION("Unknown parent") {
+        std::vector<PatchOperation> patch = {
+            PatchOperation{PatchOperation::Kind::add, NodeRecord{1, 'T', 5, {"c"}}},
+            PatchOperation{PatchOperation::Kind::add, NodeRecord{99, 'T', 6, {"d"}}}
+        };
+
+        REQUIRE_THROWS_AS(tree.apply_patch(patch), HMIException);
+        REQUIRE(tree.get_node(5).get_id() == 5);
+        REQUIRE_THROWS_AS(tree.apply_patch({
+            PatchOperation{PatchOperation::Kind::move, NodeRecord{99, 'T', 2, {}}}
+        }), HMIException);
+        REQUIRE(tree.get_node(1).get_children().size() == 2);
+    }
+
+    SECTION("Parent attached outside of the tree") {
+        Node *widget = new HMIWidget(50);
+
+        tree.get_root().add_child(widget);  // not indexed by the tree
+        tree.add_reference(50, 2);
+        for (PatchOperation::Kind kind : {PatchOperation::Kind::remove, PatchOperation::Kind::move,
+                PatchOperation::Kind::retype}) {
+            REQUIRE_THROWS_AS(tree.apply_patch({PatchOperation{kind, NodeRecord{3, 'W', 2, {}}}}),
+                    HMIException);
+            REQUIRE(tree.get_node(2).get_parents().size() == 2);
+            REQUIRE(tree.get_node(2).to_letter() == 'T');
+        }
+    }
+
+    SECTION("Root") {
+        std::vector<PatchOperation> patch = {
+            PatchOperation{PatchOperation::Kind::remove, NodeRecord{0, 'W', 0, {}}}
+        };
+
+        REQUIRE_THROWS_AS(tree.apply_patch(patch), HMIException);
+        REQUIRE(tree.get_root().get_children().size() == 2);
+    }
+
+    SECTION("Branch moved into itself") {
+        std::vector<PatchOperation> patch = {
+            PatchOperation{PatchOperation::Kind::move, NodeRecord{2, 'W', 1, {}}}
+        };
+
+        REQUIRE_THROWS_AS(tree.apply_patch(patch), HMIException);
+        REQUIRE(tree.get_node(1).get_parents().size() == 1);
+    }
+}
+
+TEST_CASE("Committing a transaction is all or nothing", "[hmi_tree][transaction]") {
+    HMITree tree;
+
+    tree.build(widget_records());
+
+    SECTION("No transaction") {
+        REQUIRE_THROWS_AS(tree.commit(), HMIException);
+    }
+
+    SECTION("Staged node removed in the meantime") {
+        std::vector<PatchOperation> patch = {
+            PatchOperation{PatchOperation::Kind::remove, NodeRecord{0, 'W', 3, {}}}
+        };
+
+        tree.begin();
+        tree.stage_update(2, {"c"});
+        tree.stage_update(4, {"d"});
+        tree.apply_patch(patch);
+        REQUIRE_THROWS_AS(tree.commit(), HMIException);
+        REQUIRE(tree.in_transaction());
+        REQUIRE_FALSE(tree.get_node(2).has_pending_update());
+    }
+
+    SECTION("Valid transaction") {
+        tree.begin();
+        tree.stage_update(2, {"c"});
+        tree.stage_update(4, {"b"});  // unchanged content
+        REQUIRE_FALSE(tree.get_node(2).has_pending_update());
+
+        tree.commit();
+        REQUIRE_FALSE(tree.in_transaction());
+        REQUIRE(tree.get_node(2).has_pending_update());
+        REQUIRE_FALSE(tree.get_node(4).has_pending_update());
+    }
+}
+
+TEST_CASE("Instances of nested prototypes keep the prototype's structure", "[hmi_tree][prototype]") {
+    HMITree tree;
+
+    tree.build({
+        NodeRecord{0, 'W', 1, {}},
+        NodeRecord{1, 'T', 2, {"a"}},
+        NodeRecord{1, 'W', 3, {}},
+        NodeRecord{3, 'T', 4, {"b"}},
+        NodeRecord{0, 'W', 5, {}}
+    });
+    tree.register_prototype("row", 1);
+
+    const Node& top = tree.get_node(tree.instantiate("row", 5));
+    std::string letters;
+
+    REQUIRE(top.to_letter() == 'W');
+    REQUIRE(top.get_children().size() == 2);
+    for (const Node *child : top.get_children()) {
+        letters += child->to_letter();
+        if (child->to_letter() == 'T') {
+            REQUIRE(child->get_children().empty());
+        } else {
+            REQUIRE(child->get_children().size() == 1);
+            REQUIRE((*child->get_children().begin())->to_letter() == 'T');
+        }
+    }
+    REQUIRE((letters == "TW" || letters == "WT"));
+}
@@ -0,0 +1,52 @@
+#include "catch2/catch.hpp"
+
+#include <vector>
+
+#include "tree/memory_pool.hh"
+
+using namespace hmi_tree_optimization::tree;
+
+TEST_CASE("Freed blocks are reused by allocations of their size class", "[memory_pool]") {
+    MemoryPool pool("test");
+    void *block = pool.allocate(24);
+
+    REQUIRE(pool.nlive_blocks() == 1);
+    pool.deallocate(block, 24);
+    REQUIRE(pool.nlive_blocks() == 0);
+    // 17 to 32 bytes share a size class
+    REQUIRE(pool.allocate(32) == block);
+    REQUIRE(pool.nchunks() == 1);
+    pool.deallocate(block, 32);
+}
+
+TEST_CASE("Pool grows by one chunk once a size class is exhausted", "[memory_pool]") {
+    constexpr size_t nblocks_per_chunk = 4;
+    MemoryPool pool("test", nblocks_per_chunk);
+    std::vector<void *> blocks;
+
+    REQUIRE(pool.nchunks() == 0);
+    REQUIRE(pool.nreserved_bytes() == 0);
+    for (size_t i = 0; i < nblocks_per_chunk; ++i)
+        blocks.push_back(pool.allocate(16));
+    REQUIRE(pool.nchunks() == 1);
+    blocks.push_back(pool.allocate(16));
+    REQUIRE(pool.nchunks() == 2);
+    REQUIRE(pool.nlive_blocks() == nblocks_per_chunk + 1);
+    REQUIRE(pool.nreserved_bytes() == 2 * nblocks_per_chunk * 16);
+    for (void *block : blocks)
+        pool.deallocate(block, 16);
+    REQUIRE(pool.nlive_blocks() == 0);
+    REQUIRE(pool.nchunks() == 2);  // chunks are kept until the pool is destroyed
+}
+
+TEST_CASE("Oversized requests are forwarded to the heap and counted monotonically", "[memory_pool]") {
+    MemoryPool pool("test");
+    void *block = pool.allocate(4096);
+
+    REQUIRE(block != nullptr);
+    REQUIRE(pool.noversized() == 1);
+    REQUIRE(pool.nlive_blocks() == 0);
+    REQUIRE(pool.nchunks() == 0);
+    pool.deallocate(block, 4096);
+    REQUIRE(pool.noversized() == 1);
+}
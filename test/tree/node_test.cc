@@ -0,0 +1,28 @@
+#include "catch2/catch.hpp"
+
+#include <vector>
+
+#include "tree/hmi_tree.hh"
+#include "tree/node.hh"
+
+using namespace hmi_tree_optimization::tree;
+
+TEST_CASE("Subtree hashes tell apart contents whose string ids are reused", "[node][hash]") {
+    HMITree tree;
+
+    tree.build({
+        NodeRecord{0, 'W', 1, {}},
+        NodeRecord{1, 'T', 2, {"node_test A"}}
+    });
+
+    Node& widget = tree.get_node(1);
+    Node& text = tree.get_node(2);
+    size_t hash = widget.subtree_hash();
+
+    // "node_test C" reuses the id of the released "node_test A"
+    text.update({"node_test B"}).apply_pending_update();
+    text.update({"node_test C"}).apply_pending_update();
+    REQUIRE(widget.subtree_hash() != hash);
+    text.update({"node_test A"}).apply_pending_update();
+    REQUIRE(widget.subtree_hash() == hash);
+}
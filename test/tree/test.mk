@@ -1,6 +1,6 @@
 # C++ source files of 'tree' module's tests.
 # They are prepended their module's relative path to the main Makefile.
-TREE__TEST_SRC :=
+TREE__TEST_SRC := memory_pool_test.cc node_test.cc hmi_tree_test.cc
 TREE__TEST_SRC := $(patsubst %,$(TEST)/$(TREE__MODULE_NAME)/%,$(TREE__TEST_SRC))
 
 # Object files of 'tree' module's tests.
@@ -28,7 +28,7 @@ tree_test: $(TEST_CONFIG_OBJ) $(TEST_MODULE_OBJ) $(TREE__TEST_OBJ) \
 			  $(TREE__TEST_OBJ), \
 			  $(CXX) $(CXXFLAGS) -o $(patsubst $(TEST_OBJ)/%.o,$(TEST_OUT)/%,$(obj)) \
 			  $(TEST_CONFIG_OBJ) $(TEST_MODULE_OBJ) \
-			  $(obj) $(TREE__OBJ) $(HELPER_OBJ) $(LIBS)$(NEWLINE))
+			  $(obj) $(sort $(TREE__OBJ) $(HELPER_OBJ)) $(LIBS)$(NEWLINE))
 	@echo $(LOG_STAMP): $(TREE__MODULE_NAME) tests compilation successful.
 
 # Make target for 'tree' module's tests' object files.